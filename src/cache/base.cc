@@ -33,6 +33,16 @@ inline static string::size_type revision_index(const string& ver) {
 	return string::npos;
 }
 
+bool BasicCache::get_fingerprint(const char *cat_name, string *fingerprint) {
+	bool exists(readCategoryPrepare(cat_name));
+	readCategoryFinalize();
+	if(exists) {
+		return false;
+	}
+	fingerprint->assign(1, '-');
+	return true;
+}
+
 void BasicCache::setScheme(const char *prefix, const char *prefixport, const std::string& scheme) {
 	m_scheme = scheme;
 	if(use_prefixport()) {
@@ -86,7 +96,9 @@ void BasicCache::env_add_package(WordMap *env, const Package& package, const Ver
 		(*env)["EPREFIX"] = m_prefix;
 		(*env)["EROOT"]   = eroot;
 	}
-	string portdir((*portagesettings)["PORTDIR"]);
+	// Use the const operator[] which is thread-safe
+	const PortageSettings& settings(*portagesettings);
+	string portdir(settings["PORTDIR"]);
 	(*env)["ECLASSDIR"] = eroot + portdir + "/eclass";
 
 	// Set variables from portagesettings (make.globals/make.conf/...)
@@ -60,6 +60,11 @@ class BasicCache {
 		virtual void setVerbose() {
 		}
 
+		/// Set the number of processes the method may run in parallel
+		virtual void setJobs(unsigned int jobs ATTRIBUTE_UNUSED) {
+			UNUSED(jobs);
+		}
+
 		/// Get overlay-key
 		ExtendedVersion::Overlay getKey() const {
 			return m_overlay_key;
@@ -94,6 +99,20 @@ class BasicCache {
 			return false;
 		}
 
+		/** Can the method read different categories in parallel?
+		    In this case, clone() must be overloaded, and the functions
+		    readCategoryPrepare(), readCategory() and readCategoryFinalize()
+		    of different clones must be thread-safe against each other. */
+		virtual bool can_read_parallel() const ATTRIBUTE_CONST_VIRTUAL {
+			return false;
+		}
+
+		/** @return a copy of the fully initialized cache which can be used
+		    to read other categories in parallel */
+		virtual BasicCache *clone() const {
+			return NULLPTR;
+		}
+
 		/** If available, the function to read multiple categories.
 		    @param packagetree should point to packagetree. The other parameters are only used if packagetree is NULLPTR:
 		    @param cat_name If packagetree is NULLPTR, only packages with this category name are read.
@@ -134,6 +153,13 @@ class BasicCache {
 			m_catname.clear();
 		}
 
+		/** Get a fingerprint of the data of a category for incremental updates:
+		    If the fingerprint has not changed, the category need not be read again.
+		    The default implementation only recognizes a missing category.
+		    Must not be called between readCategoryPrepare() and readCategoryFinalize().
+		    @return false if no reliable fingerprint is available */
+		virtual bool get_fingerprint(const char *cat_name, std::string *fingerprint) ATTRIBUTE_NONNULL_;
+
 		virtual time_t get_time(const char *pkg_name ATTRIBUTE_UNUSED, const char *ver_name ATTRIBUTE_UNUSED) const ATTRIBUTE_NONNULL_ {
 			UNUSED(pkg_name);
 			UNUSED(ver_name);
@@ -21,6 +21,7 @@
 #include "eixTk/i18n.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
+#include "eixTk/threads.h"
 #include "portage/depend.h"
 #include "portage/package.h"
 
@@ -31,8 +32,9 @@ using std::ifstream;
 static WordMap *get_map_from_cache(const char *file) ATTRIBUTE_NONNULL_;
 
 static WordMap *get_map_from_cache(const char *file) {
-	static string *oldfile = NULLPTR;
-	static WordMap *cf;
+	// Each thread has its own cache
+	static THREAD_LOCAL string *oldfile = NULLPTR;
+	static THREAD_LOCAL WordMap *cf;
 	if(unlikely(oldfile == NULLPTR)) {
 		oldfile = new string(file);
 		cf = new WordMap;
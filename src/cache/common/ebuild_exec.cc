@@ -18,6 +18,7 @@
 #include <csignal>
 #include <cstdlib>
 #include <cstring>
+#include <ctime>
 
 #include <string>
 
@@ -50,6 +51,7 @@ class EbuildExecSettings {
 		string ebuild_depend_temp;
 		string portage_rootpath;
 		string portage_bin_path, portage_pym_path, exec_ebuild_sh;
+		unsigned int timeout;
 		bool read_portage_paths, know_portage_paths;
 
 		void init();
@@ -135,23 +137,22 @@ void EbuildExec::remove_handler() {
 }
 
 // You should have called add_handler() in advance
-bool EbuildExec::make_tempfile() {
+bool EbuildExec::make_tempfile(string *cachefile) {
 	char temp[256];
 	strcpy(temp, "/tmp/ebuild-cache.XXXXXXXX");  // NOLINT(runtime/printf)
 	int fd(mkstemp(temp));
 	if(fd == -1) {
 		return false;
 	}
-	cachefile.assign(temp);
-	cache_defined = true;
+	cachefile->assign(temp);
 	close(fd);
 	return true;
 }
 
-void EbuildExec::delete_cachefile() {
-	if(unlikely(!cache_defined))
+void EbuildExec::unlink_cachefile(const Job *job) const {
+	if(unlikely(job->cachefile.empty()))
 		return;
-	const char *c(cachefile.c_str());
+	const char *c(job->cachefile.c_str());
 	if(is_pure_file(c)) {
 		if(unlink(c) < 0)
 			base->m_error_callback(eix::format(_("cannot unlink tempfile %s")) % c);
@@ -160,14 +161,32 @@ void EbuildExec::delete_cachefile() {
 	} else {
 		base->m_error_callback(eix::format(_("tempfile %s is not a file")) % c);
 	}
-	remove_handler();
-	cache_defined = false;
-	cachefile.clear();
 }
 
-/// This is a subfunction of make_cachefile() to ensure that make_cachefile()
+void EbuildExec::delete_job(Job *job) {
+	if(unlikely(job->pid != 0)) {
+		// The job was never waited for
+		kill(job->pid, SIGKILL);
+		int exec_status;
+		while(waitpid(job->pid, &exec_status, 0) != job->pid) { }
+	}
+	unlink_cachefile(job);
+	m_jobs.remove(job);
+	delete job;
+	if(m_jobs.empty()) {
+		remove_handler();
+	}
+}
+
+EbuildExec::~EbuildExec() {
+	while(!m_jobs.empty()) {
+		delete_job(m_jobs.front());
+	}
+}
+
+/// This is a subfunction of start_job() to ensure that start_job()
 /// has no local variable when vfork() is called.
-void EbuildExec::calc_environment(const char *name, const string& dir, const Package& package, const Version& version, const string& eapi) {
+void EbuildExec::calc_environment(const char *name, const string& dir, const Package& package, const Version& version, const string& eapi, const string& cachefile) {
 	c_env = NULLPTR;
 	envstrings = NULLPTR;
 	// non-sh: environment is kept except for possibly new PORTDIR_OVERLAY
@@ -237,42 +256,60 @@ void EbuildExec::calc_environment(const char *name, const string& dir, const Pac
 
 static CONSTEXPR int EXECLE_FAILED = 127;
 
-string *EbuildExec::make_cachefile(const char *name, const string& dir, const Package& package, const Version& version, const string& eapi) {
+EbuildExec::Job *EbuildExec::start_job(const char *name, const string& dir, const Package& package, const Version& version, const string& eapi) {
 	if(unlikely(!calc_settings())) {
 		return NULLPTR;
 	}
 
 	// Make cachefile and calculate exec_name
 
-	add_handler();
+	if(m_jobs.empty()) {
+		add_handler();
+	}
+	Job *job(new Job);
+	m_jobs.push_back(job);
 	if(use_ebuild_sh) {
 		exec_name = settings->exec_ebuild_sh.c_str();
-		if(!make_tempfile()) {
+		if(!make_tempfile(&(job->cachefile))) {
 			base->m_error_callback(_("creation of tempfile failed"));
-			remove_handler();
+			delete_job(job);
 			return NULLPTR;
 		}
 	} else {
 		exec_name = "ebuild";
-		cachefile = settings->ebuild_depend_temp;
-		cache_defined = true;
+		job->cachefile = settings->ebuild_depend_temp;
 	}
-	calc_environment(name, dir, package, version, eapi);
+	calc_environment(name, dir, package, version, eapi, job->cachefile);
 #ifndef HAVE_SETENV
 	if((!use_ebuild_sh) && (c_env != NULLPTR)) {
 		exec_name = settings->exec_ebuild.c_str();
 	}
 #endif
 
+	job->pid = exec_ebuild(name);
+
+	// Free memory needed only for the child process:
+	delete[] c_env;
+	delete envstrings;
+
+	if(unlikely(job->pid == -1)) {
+		base->m_error_callback(_("forking failed"));
+		job->pid = 0;
+		delete_job(job);
+		return NULLPTR;
+	}
+	job->start = time(NULLPTR);
+	return job;
+}
+
+/// This is a subfunction of start_job() to ensure that exec_ebuild()
+/// has no local variable (except for the result) when vfork() is called.
+pid_t EbuildExec::exec_ebuild(const char *name) {
 #ifdef HAVE_VFORK
 	pid_t child = vfork();
 #else
 	pid_t child = fork();
 #endif
-	if(unlikely(child == -1)) {
-		base->m_error_callback(_("forking failed"));
-		return NULLPTR;
-	}
 	if(child == 0) {
 		if(use_ebuild_sh) {
 			execle(exec_name, exec_name, "depend", static_cast<const char *>(NULLPTR), c_env);
@@ -286,29 +323,77 @@ string *EbuildExec::make_cachefile(const char *name, const string& dir, const Pa
 		}
 		_exit(EXECLE_FAILED);
 	}
-	while(waitpid(child, &exec_status, 0) != child ) { }
+	return child;
+}
 
-	// Free memory needed only for the child process:
-	delete[] c_env;
-	delete envstrings;
+/// Wait for the process of job, killing it after EBUILD_TIMEOUT seconds.
+/// @return false if the process was killed
+bool EbuildExec::wait_pid(Job *job, int *exec_status) {
+	pid_t child(job->pid);
+	job->pid = 0;
+	time_t timeout(settings->timeout);
+	if(timeout == 0) {
+		while(waitpid(child, exec_status, 0) != child) { }
+		return true;
+	}
+	while(waitpid(child, exec_status, WNOHANG) != child) {
+		if(unlikely(time(NULLPTR) - job->start >= timeout)) {
+			kill(child, SIGKILL);
+			while(waitpid(child, exec_status, 0) != child) { }
+			return false;
+		}
+		struct timespec interval;
+		interval.tv_sec = 0;
+		interval.tv_nsec = 10 * 1000 * 1000;
+		nanosleep(&interval, NULLPTR);
+	}
+	return true;
+}
+
+/// Stop all jobs, remove their files and then raise the exit signal
+void EbuildExec::abort_jobs() {
+	for(Jobs::iterator it(m_jobs.begin()); likely(it != m_jobs.end()); ++it) {
+		Job *job(*it);
+		if(job->pid != 0) {
+			kill(job->pid, type_of_exit_signal);
+			int exec_status;
+			while(waitpid(job->pid, &exec_status, 0) != job->pid) { }
+			job->pid = 0;
+		}
+		unlink_cachefile(job);
+		job->cachefile.clear();
+	}
+	remove_handler();
+	raise(type_of_exit_signal);
+}
+
+const string *EbuildExec::wait_job(Job *job) {
+	if(unlikely(job->pid == 0)) {
+		return NULLPTR;
+	}
+	int exec_status;
+	bool in_time(wait_pid(job, &exec_status));
 
 GCC_DIAG_OFF(old-style-cast)
 	// Only now we check for the child exit status or signals:
 	if(unlikely(got_exit_signal)) {
 		base->m_error_callback(eix::format(_("got signal %s")) % type_of_exit_signal);
-	} else if(unlikely(WIFSIGNALED(exec_status))) {
+	} else if(unlikely(in_time && WIFSIGNALED(exec_status))) {
 		got_exit_signal = true;
 		type_of_exit_signal = WTERMSIG(exec_status);
 		base->m_error_callback(eix::format(_("ebuild got signal %s")) % type_of_exit_signal);
 	}
 	if(unlikely(got_exit_signal)) {
-		delete_cachefile();
-		raise(type_of_exit_signal);
+		abort_jobs();
+		return NULLPTR;
+	}
+	if(unlikely(!in_time)) {
+		base->m_error_callback(eix::format(_("ebuild did not finish within %s seconds")) % settings->timeout);
 		return NULLPTR;
 	}
 	if(likely(WIFEXITED(exec_status))) {
 		if(likely(!(WEXITSTATUS(exec_status)))) {  // the only good case:
-			return &cachefile;
+			return &(job->cachefile);
 		}
 		if((WEXITSTATUS(exec_status)) == EXECLE_FAILED) {
 			base->m_error_callback(eix::format(_("could not start %s")) % exec_name);
@@ -319,7 +404,6 @@ GCC_DIAG_OFF(old-style-cast)
 		base->m_error_callback(_("child aborted in a strange way"));
 	}
 GCC_DIAG_ON(old-style-cast)
-	delete_cachefile();
 	return NULLPTR;
 }
 
@@ -375,6 +459,7 @@ void EbuildExecSettings::init() {
 #endif
 	exec_ebuild_sh = "ebuild.sh";
 	portage_rootpath = eix["PORTAGE_ROOTPATH"];
+	timeout = eix.getInteger("EBUILD_TIMEOUT");
 	read_portage_paths = false;
 }
 
@@ -10,8 +10,12 @@
 #ifndef SRC_CACHE_COMMON_EBUILD_EXEC_H_
 #define SRC_CACHE_COMMON_EBUILD_EXEC_H_ 1
 
+#include <sys/types.h>
+
 #include <csignal>
+#include <ctime>
 
+#include <list>
 #include <string>
 
 #include "eixTk/stringtypes.h"
@@ -23,16 +27,35 @@ class Version;
 
 void ebuild_sig_handler(int sig) ATTRIBUTE_SIGNAL;
 
+/** Executes "ebuild ... depend" or ebuild.sh to generate the metadata of an
+    ebuild. With ebuild.sh, up to jobs ebuilds can be executed concurrently,
+    each writing its own tempfile; the caller decides in which order it waits
+    for the results. */
 class EbuildExec {
 		friend void ebuild_sig_handler(int sig) ATTRIBUTE_SIGNAL;
 		friend class EbuildExecSettings;
 
+	public:
+		/// An ebuild which is executed in the background
+		class Job {
+				friend class EbuildExec;
+
+			private:
+				std::string cachefile;
+				pid_t pid;
+				time_t start;
+
+				Job() : pid(0), start(0) {
+				}
+		};
+
 	private:
+		typedef std::list<Job *> Jobs;
+
 		const BasicCache *base;
 		static EbuildExec *handler_arg;
-		volatile bool have_set_signals, got_exit_signal, cache_defined;
+		volatile bool have_set_signals, got_exit_signal;
 		volatile int type_of_exit_signal;
-		std::string cachefile;
 #ifdef HAVE_SIGACTION
 		struct sigaction handleTERM, handleINT, handleHUP, m_handler;
 #else
@@ -41,34 +64,60 @@ class EbuildExec {
 		/* volatile */ signal_handler *handleTERM, *handleINT, *handleHUP;
 #endif
 		bool use_ebuild_sh;
-		/// local data for make_cachefile which should be saved for vfork:
+		unsigned int max_jobs;
+		/// The jobs which were started and not yet deleted
+		Jobs m_jobs;
+		/// local data for start_job which should be saved for vfork:
 		const char *exec_name;
 		const char **c_env;
-		int exec_status;
 		WordVec *envstrings;
-		void calc_environment(const char *name, const std::string& dir, const Package& package, const Version& version, const std::string& eapi) ATTRIBUTE_NONNULL_;
+		void calc_environment(const char *name, const std::string& dir, const Package& package, const Version& version, const std::string& eapi, const std::string& cachefile) ATTRIBUTE_NONNULL_;
 
 		static EbuildExecSettings *settings;
 
 		void add_handler();
 		void remove_handler();
-		bool make_tempfile();
+		bool make_tempfile(std::string *cachefile) ATTRIBUTE_NONNULL_;
+		void unlink_cachefile(const Job *job) const ATTRIBUTE_NONNULL_;
+		bool wait_pid(Job *job, int *exec_status) ATTRIBUTE_NONNULL_;
+		void abort_jobs();
+		pid_t exec_ebuild(const char *name) ATTRIBUTE_NONNULL_;
 		bool portageq(std::string *result, const char *var) const;
 		bool calc_settings();
 
 	public:
-		std::string *make_cachefile(const char *name, const std::string& dir, const Package& package, const Version& version, const std::string& eapi) ATTRIBUTE_NONNULL_;
-		void delete_cachefile();
+		/// Start the execution of the ebuild name. If full(), the caller
+		/// should wait for an earlier job first.
+		/// @return NULLPTR on failure
+		Job *start_job(const char *name, const std::string& dir, const Package& package, const Version& version, const std::string& eapi) ATTRIBUTE_NONNULL_;
+
+		/// Wait until job is finished.
+		/// @return the file containing the metadata or NULLPTR on failure
+		const std::string *wait_job(Job *job) ATTRIBUTE_NONNULL_;
+
+		/// Remove the file of job and free it.
+		void delete_job(Job *job) ATTRIBUTE_NONNULL_;
+
+		/// Is the maximal number of jobs reached?
+		bool full() const {
+			return (m_jobs.size() >= max_jobs);
+		}
 
 		EbuildExec(bool will_use_sh, const BasicCache *b) ATTRIBUTE_NONNULL_ :
 			base(b),
 			have_set_signals(false),
-			cache_defined(false),
-			use_ebuild_sh(will_use_sh) {
+			use_ebuild_sh(will_use_sh),
+			max_jobs(1) {
 		}
 
-		~EbuildExec() {
-			delete_cachefile();
+		~EbuildExec();
+
+		/// Set the maximal number of concurrent jobs. Only ebuild.sh uses
+		/// tempfiles, so "ebuild ... depend" is always executed serially.
+		void set_jobs(unsigned int jobs) {
+			if(use_ebuild_sh && (jobs > 1)) {
+				max_jobs = jobs;
+			}
 		}
 
 		bool use_sh() const {
@@ -10,21 +10,25 @@
 #include <config.h>
 
 #include <dirent.h>
+#include <sys/stat.h>
 
 #include <cstdlib>
 #include <cstring>
+#include <ctime>
 
 #include <string>
 
 #include "cache/common/assign_reader.h"
 #include "cache/common/flat_reader.h"
 #include "cache/metadata/metadata.h"
+#include "eixTk/digest.h"
 #include "eixTk/formated.h"
 #include "eixTk/i18n.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
+#include "eixTk/sysutils.h"
 #include "eixTk/utils.h"
 #include "portage/basicversion.h"
 #include "portage/extendedversion.h"
@@ -256,6 +260,38 @@ bool MetadataCache::readCategoryPrepare(const char *cat_name) {
 	return scandir_cc(m_catpath, &names, cachefiles_selector);
 }
 
+bool MetadataCache::get_fingerprint(const char *cat_name, string *fingerprint) {
+	if(!readCategoryPrepare(cat_name)) {
+		readCategoryFinalize();
+		fingerprint->assign(1, '-');
+		return true;
+	}
+	// Hash the names, modification times, and sizes of all cache files,
+	// so that also files which are modified in place are noticed.
+	// An mtime from the current second is not reliable, since the file
+	// might still be modified within the same second.
+	time_t now(time(NULLPTR));
+	Digest digest;
+	bool reliable(true);
+	for(WordVec::const_iterator it(names.begin()); likely(it != names.end()); ++it) {
+		struct stat st;
+		if(unlikely(stat((m_catpath + "/" + *it).c_str(), &st) != 0) ||
+			unlikely(st.st_mtime >= now)) {
+			reliable = false;
+			break;
+		}
+		digest.add(*it);
+		digest.add(static_cast<uint64_t>(st.st_mtime));
+		digest.add(static_cast<uint64_t>(st.st_size));
+	}
+	if(reliable) {
+		*fingerprint = eix::format("%s:%s:") % m_catpath % names.size();
+		fingerprint->append(digest.get());
+	}
+	readCategoryFinalize();
+	return reliable;
+}
+
 void MetadataCache::readCategoryFinalize() {
 	m_catname.clear();
 	m_catpath.clear();
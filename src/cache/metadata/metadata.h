@@ -50,6 +50,16 @@ class MetadataCache : public BasicCache {
 	public:
 		bool initialize(const std::string& name);
 
+		bool can_read_parallel() const ATTRIBUTE_CONST_VIRTUAL {
+			return true;
+		}
+
+		BasicCache *clone() const {
+			return new MetadataCache(*this);
+		}
+
+		bool get_fingerprint(const char *cat_name, std::string *fingerprint) ATTRIBUTE_NONNULL_;
+
 		bool readCategoryPrepare(const char *cat_name) ATTRIBUTE_NONNULL_;
 		bool readCategory(Category *cat) ATTRIBUTE_NONNULL_;
 		void readCategoryFinalize();
@@ -13,6 +13,7 @@
 #include <ctime>
 
 #include <string>
+#include <vector>
 
 #include "cache/base.h"
 #include "cache/common/ebuild_exec.h"
@@ -28,6 +29,7 @@
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
 #include "eixTk/sysutils.h"
+#include "eixTk/threads.h"
 #include "eixTk/varsreader.h"
 #include "portage/basicversion.h"
 #include "portage/depend.h"
@@ -38,6 +40,83 @@
 
 using std::string;
 
+class ParseCache::Pending {
+	public:
+		Package *pkg;
+		/// NULLPTR for the end of the package
+		Version *version;
+
+		/// Whether the ebuild should be parsed or executed
+		bool parse;
+		bool read_onetime_info;
+		string fullpath, dirpath;
+
+		/// Data of the version and of the package obtained by parsing
+		string keywords, restr, props, iuse, slot, eapi;
+		bool have_common;
+		string homepage, licenses, desc;
+		bool parse_failed;
+		string parse_error;
+
+		/// The further cache to take the data from or NULLPTR
+		const BasicCache *further_cache;
+		string ver;
+
+		/// Whether the ebuild must be executed, and if so, the job (if started)
+		bool exec;
+		EbuildExec::Job *job;
+
+		/// For the end of the package: The category to add it to
+		/// (if it is new) or whether it should be deleted
+		Category *cat;
+		bool delete_pkg;
+
+		Pending(Package *p, Version *v) :
+			pkg(p), version(v), parse(false), read_onetime_info(false),
+			have_common(false), parse_failed(false), further_cache(NULLPTR), exec(false), job(NULLPTR),
+			cat(NULLPTR), delete_pkg(false) {
+		}
+};
+
+/** The ebuilds of a category which are parsed in parallel threads */
+class ParseWork {
+	public:
+		const ParseCache *cache;
+		typedef std::vector<ParseCache::Pending *> Work;
+		Work work;
+
+		explicit ParseWork(const ParseCache *c) : cache(c), m_next(0) {
+		}
+
+		/// @return false if there is no ebuild left
+		bool next(Work::size_type *i) ATTRIBUTE_NONNULL_ {
+			eix::MutexLocker locker(&mutex);
+			if(m_next == work.size()) {
+				return false;
+			}
+			*i = m_next++;
+			return true;
+		}
+
+		static void worker(void *data);
+
+	private:
+		Work::size_type m_next;
+		eix::Mutex mutex;
+};
+
+void ParseWork::worker(void *data) {
+	ParseWork *w(static_cast<ParseWork *>(data));
+	// Each thread reuses its reader and the map for all its ebuilds
+	WordMap env;
+	VarsReader ebuild(VarsReader::INTO_MAP);
+	ebuild.useMap(&env);
+	ParseWork::Work::size_type i;
+	while(likely(w->next(&i))) {
+		w->cache->parse(w->work[i], &ebuild, &env);
+	}
+}
+
 bool ParseCache::initialize(const string& name) {
 	WordVec names;
 	split_string(&names, name, true, "#");
@@ -127,12 +206,18 @@ ParseCache::~ParseCache() {
 		delete *it;
 	}
 	if(ebuild_exec != NULLPTR) {
-		ebuild_exec->delete_cachefile();
 		delete ebuild_exec;
 		ebuild_exec = NULLPTR;
 	}
 }
 
+void ParseCache::setJobs(unsigned int jobs) {
+	m_jobs = jobs;
+	if(ebuild_exec != NULLPTR) {
+		ebuild_exec->set_jobs(jobs);
+	}
+}
+
 void ParseCache::setScheme(const char *prefix, const char *prefixport, const std::string& scheme) {
 	BasicCache::setScheme(prefix, prefixport, scheme);
 	for(FurtherCaches::iterator it(further.begin());
@@ -165,7 +250,7 @@ void ParseCache::setErrorCallback(ErrorCallback error_callback) {
 	}
 }
 
-void ParseCache::set_checking(string *str, const char *item, const VarsReader& ebuild, bool *ok) {
+void ParseCache::set_checking(string *str, const char *item, const VarsReader& ebuild, bool *ok) const {
 	bool check((ebuild_exec != NULLPTR) && (ok != NULLPTR) && (*ok));
 	const string *s(ebuild.find(item));
 	str->clear();
@@ -185,94 +270,173 @@ void ParseCache::set_checking(string *str, const char *item, const VarsReader& e
 	}
 }
 
-void ParseCache::parse_exec(const char *fullpath, const string& dirpath, bool read_onetime_info, bool *have_onetime_info, Package *pkg, Version *version) {
-	version->overlay_key = m_overlay_key;
-	string keywords, restr, props, iuse, slot, eapi;
+void ParseCache::parse(Pending *p, VarsReader *ebuild, WordMap *env) const {
+	Package *pkg(p->pkg);
+	Version *version(p->version);
+	const char *fullpath(p->fullpath.c_str());
 	bool ok(try_parse);
 	if(ok || ebuild_sh) {
-		VarsReader::Flags flags(VarsReader::NONE);
-		if(!read_onetime_info) {
+		VarsReader::Flags flags(VarsReader::INTO_MAP);
+		if(!p->read_onetime_info) {
 			flags |= VarsReader::ONLY_KEYWORDS_SLOT;
 		}
-		WordMap env;
+		env->clear();
 		if(!nosubst) {
-			flags |= VarsReader::INTO_MAP | VarsReader::SUBST_VARS;
-			env_add_package(&env, *pkg, *version, dirpath, fullpath);
-		}
-		VarsReader ebuild(flags);
-		if(flags & VarsReader::INTO_MAP) {
-			ebuild.useMap(&env);
-		}
-		string errtext;
-		if(!ebuild.read(fullpath, &errtext, false)) {
-			m_error_callback(eix::format(_("cannot properly parse %s: %s")) % fullpath % errtext);
+			flags |= VarsReader::SUBST_VARS;
+			env_add_package(env, *pkg, *version, p->dirpath, fullpath);
 		}
+		ebuild->setFlags(flags);
+		// The error is reported in the order of reading
+		p->parse_failed = !ebuild->read(fullpath, &(p->parse_error), false);
 
 		bool set_eapi(ebuild_sh);
 		if(ok) {
-			set_checking(&keywords, "KEYWORDS", ebuild, &ok);
-			set_checking(&slot, "SLOT", ebuild, &ok);
+			set_checking(&(p->keywords), "KEYWORDS", *ebuild, &ok);
+			set_checking(&(p->slot), "SLOT", *ebuild, &ok);
 			// Empty SLOT is not ok:
-			if(ok && (ebuild_exec != NULLPTR) && slot.empty()) {
+			if(ok && (ebuild_exec != NULLPTR) && p->slot.empty()) {
 				ok = false;
 			}
-			set_checking(&restr, "RESTRICT", ebuild);
-			set_checking(&props, "PROPERTIES", ebuild);
-			set_checking(&iuse, "IUSE", ebuild, &ok);
+			set_checking(&(p->restr), "RESTRICT", *ebuild);
+			set_checking(&(p->props), "PROPERTIES", *ebuild);
+			set_checking(&(p->iuse), "IUSE", *ebuild, &ok);
 			if(Depend::use_depend) {
 				string depend, rdepend, pdepend, hdepend;
-				set_checking(&depend, "DEPEND", ebuild);
-				set_checking(&rdepend, "RDEPEND", ebuild);
-				set_checking(&pdepend, "PDEPEND", ebuild);
-				set_checking(&hdepend, "HDEPEND", ebuild);
+				set_checking(&depend, "DEPEND", *ebuild);
+				set_checking(&rdepend, "RDEPEND", *ebuild);
+				set_checking(&pdepend, "PDEPEND", *ebuild);
+				set_checking(&hdepend, "HDEPEND", *ebuild);
 				version->depend.set(depend, rdepend, pdepend, hdepend, true);
 			}
-			if(read_onetime_info) {
-				set_checking(&(pkg->homepage), "HOMEPAGE",    ebuild, &ok);
-				set_checking(&(pkg->licenses), "LICENSE",     ebuild, &ok);
-				set_checking(&(pkg->desc),     "DESCRIPTION", ebuild, &ok);
-				*have_onetime_info = true;
+			if(p->read_onetime_info) {
+				set_checking(&(p->homepage), "HOMEPAGE",    *ebuild, &ok);
+				set_checking(&(p->licenses), "LICENSE",     *ebuild, &ok);
+				set_checking(&(p->desc),     "DESCRIPTION", *ebuild, &ok);
+				p->have_common = true;
 			}
 			set_eapi = !ok;
 		}
 		if(set_eapi) {
-			const string *s(ebuild.find("EAPI"));
+			const string *s(ebuild->find("EAPI"));
 			if(likely(s != NULLPTR)) {
-				eapi = *s;
+				p->eapi = *s;
 			} else {
-				eapi.assign("0");
+				p->eapi.assign("0");
 			}
 		}
 	}
+	p->exec = !ok;
+}
+
+/**
+    Parse all pending ebuilds of the category, in parallel threads
+    if possible. Everything else is done in the order of reading.
+*/
+void ParseCache::parse_pending() {
+	ParseWork work(this);
+	for(PendingList::const_iterator it(m_pending.begin());
+		likely(it != m_pending.end()); ++it) {
+		if((*it)->parse) {
+			work.work.push_back(*it);
+		}
+	}
+	if(work.work.empty()) {
+		return;
+	}
+	unsigned int jobs(m_jobs);
+	if(jobs > work.work.size()) {
+		jobs = static_cast<unsigned int>(work.work.size());
+	}
+	eix::run_parallel(jobs, ParseWork::worker, &work);
+}
+
+void ParseCache::start(Pending *p) {
+	if(p->version == NULLPTR) {
+		return;
+	}
+	if(unlikely(p->parse_failed)) {
+		m_error_callback(eix::format(_("cannot properly parse %s: %s")) % p->fullpath % p->parse_error);
+	}
 	if(verbose) {
 		const char *used_type;
-		if(ok) {
+		if(p->further_cache != NULLPTR) {
+			used_type = p->further_cache->getType();
+		} else if(!p->exec) {
 			used_type = (nosubst ? "parse*" : "parse");
 		} else {
 			used_type = (ebuild_sh ? "ebuild*" : "ebuild");
 		}
 		m_error_callback(eix::format("%s/%s-%s: %s") %
-			m_catname % pkg->name % version->getFull() %
+			m_catname % p->pkg->name % p->version->getFull() %
 			used_type);
 	}
-	if(!ok) {
-		string *cachefile(ebuild_exec->make_cachefile(fullpath, dirpath, *pkg, *version, eapi));
+	if(p->exec) {
+		// The result is read in finish()
+		p->job = ebuild_exec->start_job(p->fullpath.c_str(), p->dirpath, *(p->pkg), *(p->version), p->eapi);
+	}
+}
+
+void ParseCache::finish(Pending *p) {
+	Package *pkg(p->pkg);
+	Version *version(p->version);
+	if(version == NULLPTR) {
+		if(p->cat != NULLPTR) {
+			p->cat->addPackage(pkg);
+		} else if(p->delete_pkg) {
+			delete pkg;
+		}
+		return;
+	}
+	if(p->further_cache != NULLPTR) {
+		p->further_cache->get_version_info(pkg->name.c_str(), p->ver.c_str(), version);
+		if(p->read_onetime_info) {
+			p->further_cache->get_common_info(pkg->name.c_str(), p->ver.c_str(), pkg);
+		}
+		pkg->addVersionFinalize(version);
+		return;
+	}
+	if(p->have_common) {
+		pkg->homepage.swap(p->homepage);
+		pkg->licenses.swap(p->licenses);
+		pkg->desc.swap(p->desc);
+	}
+	if(p->exec) {
+		const string *cachefile((p->job != NULLPTR) ? ebuild_exec->wait_job(p->job) : NULLPTR);
 		if(likely(cachefile != NULLPTR)) {
-			flat_get_keywords_slot_iuse_restrict(*cachefile, &keywords, &slot, &iuse, &restr, &props, &(version->depend), m_error_callback);
+			flat_get_keywords_slot_iuse_restrict(*cachefile, &(p->keywords), &(p->slot), &(p->iuse), &(p->restr), &(p->props), &(version->depend), m_error_callback);
 			flat_read_file(cachefile->c_str(), pkg, m_error_callback);
-			ebuild_exec->delete_cachefile();
 		} else {
-			m_error_callback(eix::format(_("cannot properly execute %s")) % fullpath);
+			m_error_callback(eix::format(_("cannot properly execute %s")) % p->fullpath);
+		}
+		if(p->job != NULLPTR) {
+			ebuild_exec->delete_job(p->job);
 		}
 	}
-	version->set_slotname(slot);
-	version->set_full_keywords(keywords);
-	version->set_restrict(restr);
-	version->set_properties(props);
-	version->set_iuse(iuse);
+	version->set_slotname(p->slot);
+	version->set_full_keywords(p->keywords);
+	version->set_restrict(p->restr);
+	version->set_properties(p->props);
+	version->set_iuse(p->iuse);
 	pkg->addVersionFinalize(version);
 }
 
+/**
+    Finish the started versions in the order of reading. A version whose
+    ebuild is still executed is waited for only if all is set or if no
+    further ebuild can be started.
+*/
+void ParseCache::finish_started(bool all) {
+	while(!m_started.empty()) {
+		Pending *p(m_started.front());
+		if((p->job != NULLPTR) && !all && !ebuild_exec->full()) {
+			return;
+		}
+		m_started.pop_front();
+		finish(p);
+		delete p;
+	}
+}
+
 void ParseCache::readPackage(Category *cat, const string& pkg_name, const string& directory_path, const WordVec& files) {
 	bool have_onetime_info, have_pkg;
 
@@ -311,6 +475,8 @@ void ParseCache::readPackage(Category *cat, const string& pkg_name, const string
 			continue;
 		}
 		pkg->addVersionStart(version);
+		Pending *p(new Pending(pkg, version));
+		m_pending.push_back(p);
 
 		string full_path(directory_path + '/' + (*fileit));
 
@@ -342,17 +508,20 @@ void ParseCache::readPackage(Category *cat, const string& pkg_name, const string
 				}
 			}
 		}
+		p->read_onetime_info = read_onetime_info;
 		if(it == further.end()) {
-			parse_exec(full_path.c_str(), directory_path, read_onetime_info, &have_onetime_info, pkg, version);
-		} else {
-			if(verbose) {
-				m_error_callback(eix::format("%s/%s-%s: %s") %
-					m_catname % pkg_name % version->getFull() %
-					(*it)->getType());
+			// The ebuild is parsed later on by parse()
+			version->overlay_key = m_overlay_key;
+			p->parse = true;
+			p->fullpath.swap(full_path);
+			p->dirpath = directory_path;
+			if(try_parse && read_onetime_info) {
+				have_onetime_info = true;
 			}
-			(*it)->get_version_info(pkg_name.c_str(), ver, version);
+		} else {
+			p->further_cache = *it;
+			p->ver.assign(ver);
 			if(read_onetime_info) {
-				(*it)->get_common_info(pkg_name.c_str(), ver, pkg);
 				have_onetime_info = true;
 			}
 		}
@@ -360,13 +529,13 @@ void ParseCache::readPackage(Category *cat, const string& pkg_name, const string
 		free(ver);
 	}
 
-	if(have_onetime_info) {
-		if(!have_pkg) {
-			cat->addPackage(pkg);
-		}
-	} else {
-		delete pkg;
+	Pending *p(new Pending(pkg, NULLPTR));
+	if(!have_onetime_info) {
+		p->delete_pkg = true;
+	} else if(!have_pkg) {
+		p->cat = cat;
 	}
+	m_pending.push_back(p);
 }
 
 bool ParseCache::readCategoryPrepare(const char *cat_name) {
@@ -400,5 +569,14 @@ bool ParseCache::readCategory(Category *cat) {
 			readPackage(cat, *pit, pkg_path, files);
 		}
 	}
+	parse_pending();
+	while(!m_pending.empty()) {
+		Pending *p(m_pending.front());
+		m_pending.pop_front();
+		start(p);
+		m_started.push_back(p);
+		finish_started(false);
+	}
+	finish_started(true);
 	return true;
 }
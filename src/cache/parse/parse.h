@@ -10,6 +10,7 @@
 #ifndef SRC_CACHE_PARSE_PARSE_H_
 #define SRC_CACHE_PARSE_PARSE_H_ 1
 
+#include <list>
 #include <string>
 #include <vector>
 
@@ -24,6 +25,8 @@ class VarsReader;
 class Version;
 
 class ParseCache : public BasicCache {
+		friend class ParseWork;
+
 	private:
 		bool verbose;
 		typedef std::vector<BasicCache*> FurtherCaches;
@@ -32,19 +35,34 @@ class ParseCache : public BasicCache {
 		FurtherWorks further_works;
 		bool try_parse, nosubst, ebuild_sh;
 		EbuildExec *ebuild_exec;
+		unsigned int m_jobs;
 		WordVec m_packages;
 		std::string m_catpath;
 
-		void set_checking(std::string *str, const char *item, const VarsReader& ebuild, bool *ok) ATTRIBUTE_NONNULL((2, 3));
-		void set_checking(std::string *str, const char *item, const VarsReader& ebuild) ATTRIBUTE_NONNULL_ {
+		/// A version (or the end of a package) whose data is completed
+		/// in the order of reading
+		class Pending;
+		typedef std::list<Pending *> PendingList;
+		/// The versions of the category which are not yet started
+		PendingList m_pending;
+		/// The versions which wait for their ebuild or for earlier ones
+		PendingList m_started;
+
+		void set_checking(std::string *str, const char *item, const VarsReader& ebuild, bool *ok) const ATTRIBUTE_NONNULL((2, 3));
+		void set_checking(std::string *str, const char *item, const VarsReader& ebuild) const ATTRIBUTE_NONNULL_ {
 			set_checking(str, item, ebuild, NULLPTR);
 		}
 
-		void parse_exec(const char *fullpath, const std::string& dirpath, bool read_onetime_info, bool *have_onetime_info, Package *pkg, Version *version) ATTRIBUTE_NONNULL_;
+		/// Parse the ebuild of p. This is thread-safe for different p.
+		void parse(Pending *p, VarsReader *ebuild, WordMap *env) const ATTRIBUTE_NONNULL_;
+		void parse_pending();
+		void start(Pending *p) ATTRIBUTE_NONNULL_;
+		void finish_started(bool all);
+		void finish(Pending *p) ATTRIBUTE_NONNULL_;
 		void readPackage(Category *cat, const std::string& pkg_name, const std::string& directory_path, const WordVec& files) ATTRIBUTE_NONNULL_;
 
 	public:
-		ParseCache() : BasicCache(), verbose(false), ebuild_exec(NULLPTR) {
+		ParseCache() : BasicCache(), verbose(false), ebuild_exec(NULLPTR), m_jobs(1) {
 		}
 
 		bool initialize(const std::string& name);
@@ -58,6 +76,7 @@ class ParseCache : public BasicCache {
 		void setVerbose() {
 			verbose = true;
 		}
+		void setJobs(unsigned int jobs);
 
 		bool readCategoryPrepare(const char *cat_name) ATTRIBUTE_NONNULL_;
 		bool readCategory(Category *cat) ATTRIBUTE_NONNULL_;
@@ -14,28 +14,26 @@
 #ifdef WITH_SQLITE
 #include <sqlite3.h>
 
-#include <cstdlib>
+#include <cstring>
 
 #ifdef SQLITE_ONLY_DEBUG
 #include <iostream>
 #endif
-#include <map>
 #include <string>
 
 #include "cache/sqlite/sqlite.h"
+#include "eixTk/diagnostics.h"
 #include "eixTk/formated.h"
 #include "eixTk/i18n.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
 #include "eixTk/stringutils.h"
-#include "eixTk/unused.h"
 #include "portage/basicversion.h"
 #include "portage/depend.h"
 #include "portage/package.h"
 #include "portage/packagetree.h"
 #include "portage/version.h"
 
-using std::map;
 using std::string;
 
 #ifdef SQLITE_ONLY_DEBUG
@@ -45,237 +43,218 @@ using std::cout;
 /* Path to portage cache */
 #define PORTAGE_CACHE_PATH "/var/cache/edb/dep"
 
-
-
-/** All stuff related to our sqlite_callback()
-    Essentially, this is just a C-wrapper to get the implicit this argument in */
-
-SqliteCache *SqliteCache::callback_arg;
-
-inline static const char *welldefine(const char *s) ATTRIBUTE_CONST;
-
-inline static const char *welldefine(const char *s) {
-	return ((s != NULLPTR) ? s : "");
-}
-
-int sqlite_callback(void *NotUsed ATTRIBUTE_UNUSED, int argc, char **argv, char **azColName) {
-	UNUSED(NotUsed);
-#ifdef SQLITE_ONLY_DEBUG
-	for(int i(0); likely(i < argc); ++i) {
-		cout << eix::format("%s: %s = %s\n")
-			% i % azColName[i] % welldefine(argv[i]);
-	}
-#else
-	SqliteCache::callback_arg->sqlite_callback_cpp(argc, const_cast<const char **>(argv), const_cast<const char **>(azColName));
-#endif
-	return 0;
-}
-
 /**
-    The following is all related to get the proper index for the lookups.
-    The main idea is the following: We let
-    SqliteCache::trueindex[TrueIndex::Names] = actual index or negative
-    where the negative value indicates that the data is not available
-    because the sqlite dataset is too short; the minimal dataset length
-    for all mandatory data is stored in SqliteCache::maxindex.
-
-    The class TrueIndex and the static (and only) instance *true_index
-    is used to calculate the initial value of trueindex/maxindex
-    at the first database access by first filling it with default parameters
-    and - for the case that appropriate data is stored in azColName -
-    modifying this correspondingly: This has the advantage that if some
-    portage versions use different names, we still have (hopefully correct)
-    default values.
-
-    The class TrueIndex itself is independent of SqliteCache and gets passed
-    all required data by parameters. Note that it stores nothing except for
-    the static default data, and so, except for the first initialization in
-    the constructor, all functions should be const or static.
+    The columns of the table portage_packages which we read.
+    The actual index of a column is determined from its name when the
+    query is prepared. The default index is only used if no column has
+    that name: This has the advantage that if some portage versions use
+    different names, we still have (hopefully correct) default values.
 */
 
-typedef SqliteCache::TrueIndexMap::size_type TrueIndexRes;
-typedef map<string, TrueIndexRes> TrueIndexMapper;
-
-class TrueIndex : public TrueIndexMapper {
+typedef enum {
+	NAME,
+	SLOT,
+	RESTRICT,
+	HOMEPAGE,
+	LICENSE,
+	DESCRIPTION,
+	KEYWORDS,
+	IUSE,
+	PROPERTIES,
+	DEPEND,
+	RDEPEND,
+	PDEPEND,
+	HDEPEND,
+	COLUMN_COUNT
+} SqliteColumn;
+
+class SqliteColumnData {
 	public:
-		typedef enum {
-			NAME,
-			SLOT,
-			RESTRICT,
-			HOMEPAGE,
-			LICENSE,
-			DESCRIPTION,
-			KEYWORDS,
-			IUSE,
-			PROPERTIES,
-			DEPEND,
-			RDEPEND,
-			PDEPEND,
-			HDEPEND,
-			LAST
-		} Names;
-		SqliteCache::TrueIndexMap default_trueindex;
+		const char *name;
+		int default_index;
+};
 
-	private:
-		void mapinit(int true_index, TrueIndexRes my_index, const char *s) ATTRIBUTE_NONNULL_ {
-			(*this)[s] = my_index;
-			default_trueindex[my_index] = true_index;
-		}
+static const SqliteColumnData sqlite_columns[COLUMN_COUNT] = {
+	{ "portage_package_key",  1 },
+	{ "SLOT",                18 },
+	{ "RESTRICT",            17 },
+	{ "HOMEPAGE",             7 },
+	{ "LICENSE",             11 },
+	{ "DESCRIPTION",          4 },
+	{ "KEYWORDS",            10 },
+	{ "IUSE",                 9 },
+	{ "PROPERTIES",          13 },
+	{ "DEPEND",               3 },
+	{ "RDEPEND",             15 },
+	{ "PDEPEND",             12 },
+	{ "HDEPEND",              6 }
+};
 
+class SqliteCache::Query {
 	public:
-		TrueIndex() : default_trueindex(LAST, -1) {
-			mapinit( 1, NAME,        "portage_package_key");
-			mapinit( 3, DEPEND,      "DEPEND");
-			mapinit( 4, DESCRIPTION, "DESCRIPTION");
-			mapinit( 6, HDEPEND,     "HDEPEND");
-			mapinit( 7, HOMEPAGE,    "HOMEPAGE");
-			mapinit( 9, IUSE,        "IUSE");
-			mapinit(10, KEYWORDS,    "KEYWORDS");
-			mapinit(11, LICENSE,     "LICENSE");
-			mapinit(12, PDEPEND,     "PDEPEND");
-			mapinit(13, PROPERTIES,  "PROPERTIES");
-			mapinit(15, RDEPEND,     "RDEPEND");
-			mapinit(17, RESTRICT,    "RESTRICT");
-			mapinit(18, SLOT,        "SLOT");
-		}
+		/// The index of the columns or -1 if not available
+		int columns[COLUMN_COUNT];
 
-		int calc(int argc, const char **azColName, SqliteCache::TrueIndexMap *trueindex) const ATTRIBUTE_NONNULL_ {
-			*trueindex = default_trueindex;
-			for(int i(0); i < argc; ++i) {
-				TrueIndexMapper::const_iterator it(find(azColName[i]));
-				if(it != end())
-					(*trueindex)[it->second] = i;
-			}
-			int max_index(-1);
-			for(TrueIndexRes i(0); likely(i < TrueIndex::LAST); ++i) {
-				int curr((*trueindex)[i]);
-				// Shortcut if we have not reached the maximum
-				if(max_index >= curr) {
-					continue;
-				}
-				// Is the true index out of range?
-				if(argc <= curr) {
-					(*trueindex)[i] = -1;
-					// PROPERTIES is not mandatory
-					if(i == TrueIndex::PROPERTIES) {
-						continue;
-					}
-				}
-				max_index = curr;
-			}
-			return max_index;
+		/// Parameter passing from readCategories()
+		PackageTree *packagetree;
+		Category *category;
+
+		/// The category and package of the previous row
+		string cat_name;
+		Category *dest_cat;
+		Package *pkg;
+
+		Query(PackageTree *pkgtree, Category *cat) :
+			packagetree(pkgtree), category(cat), dest_cat(NULLPTR), pkg(NULLPTR) {
 		}
 
-		static const char *c_str(const char **argv, SqliteCache::TrueIndexMap *trueindex, const TrueIndexRes i) ATTRIBUTE_NONNULL((2)) {
-			int t((*trueindex)[i]);
-			if(t < 0) {
+		/// Bind the column indices to the columns of the prepared stmt.
+		/// @return the name of a missing mandatory column or NULLPTR
+		const char *bind_columns(sqlite3_stmt *stmt) ATTRIBUTE_NONNULL_;
+
+		/// @return the text of the column of the current row (never NULLPTR)
+		const char *text(sqlite3_stmt *stmt, SqliteColumn column) const ATTRIBUTE_NONNULL_ {
+			int i(columns[column]);
+			if(unlikely(i < 0)) {
 				return "";
 			}
-			return welldefine(argv[t]);
+			const unsigned char *s(sqlite3_column_text(stmt, i));
+			return ((likely(s != NULLPTR)) ? reinterpret_cast<const char *>(s) : "");
 		}
 };
 
-TrueIndex *SqliteCache::true_index = NULLPTR;
-
-void SqliteCache::sqlite_callback_cpp(int argc, const char **argv, const char **azColName) {
-	// If an earlier error occurred, we ignore later calls:
-	if(unlikely(sqlite_callback_error)) {
-		return;
+const char *SqliteCache::Query::bind_columns(sqlite3_stmt *stmt) {
+	int count(sqlite3_column_count(stmt));
+	for(int c(0); likely(c != COLUMN_COUNT); ++c) {
+		columns[c] = sqlite_columns[c].default_index;
 	}
-
-	if(maxindex == 0) {
-		if(unlikely(true_index == NULLPTR)) {
-			true_index = new TrueIndex;
+	for(int i(0); likely(i < count); ++i) {
+		const char *name(sqlite3_column_name(stmt, i));
+		if(unlikely(name == NULLPTR)) {
+			continue;
+		}
+		for(int c(0); likely(c != COLUMN_COUNT); ++c) {
+			if(std::strcmp(name, sqlite_columns[c].name) == 0) {
+				columns[c] = i;
+				break;
+			}
 		}
-		maxindex = true_index->calc(argc, azColName, &trueindex);
 	}
-
-	if(argc <= trueindex[TrueIndex::NAME]) {
-		sqlite_callback_error = true;
-		m_error_callback(_("sqlite dataset does not contain a package name"));
-		return;
+	for(int c(0); likely(c != COLUMN_COUNT); ++c) {
+		if(likely(columns[c] < count)) {
+			continue;
+		}
+		columns[c] = -1;
+		// PROPERTIES is not mandatory
+		if(c != PROPERTIES) {
+			return sqlite_columns[c].name;
+		}
 	}
-	string catarg(TrueIndex::c_str(argv, &trueindex, TrueIndex::NAME));
-	if(argc <= maxindex) {
-		sqlite_callback_error = true;
-		m_error_callback(eix::format(_("sqlite dataset for %s is too small")) % catarg);
-		return;
+	return NULLPTR;
+}
+
+bool SqliteCache::read_row(Query *query, sqlite3_stmt *stmt) {
+#ifdef SQLITE_ONLY_DEBUG
+	for(int i(0); likely(i < sqlite3_column_count(stmt)); ++i) {
+		const unsigned char *s(sqlite3_column_text(stmt, i));
+		cout << eix::format("%s: %s = %s\n")
+			% i % sqlite3_column_name(stmt, i)
+			% ((s != NULLPTR) ? reinterpret_cast<const char *>(s) : "");
 	}
-	string::size_type pos(catarg.find('/'));
-	if(pos == string::npos) {
-		sqlite_callback_error = true;
-		m_error_callback(eix::format(_("%r not of the form package/category-version")) % catarg);
-		return;
+	return true;
+#endif
+	const char *key(query->text(stmt, NAME));
+	const char *name_ver(std::strchr(key, '/'));
+	if(unlikely(name_ver == NULLPTR)) {
+		m_error_callback(eix::format(_("%r not of the form package/category-version")) % key);
+		return false;
 	}
-	string name_ver(catarg, pos + 1);
-	catarg.resize(pos);
-	// Does the catarg match category?
-	// Currently, we do not add non-matching categories with this method.
-	Category *dest_cat;
-	if(unlikely(packagetree == NULLPTR)) {
-		if(cat_name != catarg) {
-			return;
-		}
-		dest_cat = category;
-	} else if(never_add_categories) {
-		dest_cat = packagetree->find(catarg);
-		if(unlikely(dest_cat == NULLPTR)) {
-			return;
+GCC_DIAG_OFF(sign-conversion)
+	string::size_type cat_len(name_ver - key);
+GCC_DIAG_ON(sign-conversion)
+	++name_ver;
+	// Usually, all versions of a category are consecutive
+	if((query->dest_cat == NULLPTR) ||
+		(query->cat_name.compare(0, string::npos, key, cat_len) != 0)) {
+		query->cat_name.assign(key, cat_len);
+		query->pkg = NULLPTR;
+		// Currently, we do not add non-matching categories with this method.
+		if(unlikely(query->packagetree == NULLPTR)) {
+			// The query has selected only the matching category
+			query->dest_cat = query->category;
+		} else if(never_add_categories) {
+			query->dest_cat = query->packagetree->find(query->cat_name);
+		} else {
+			query->dest_cat = &((*(query->packagetree))[query->cat_name]);
 		}
-	} else {
-		dest_cat = &((*packagetree)[catarg]);
 	}
-	char **aux(ExplodeAtom::split(name_ver.c_str()));
-	if(unlikely(aux == NULLPTR)) {
+	if(unlikely(query->dest_cat == NULLPTR)) {
+		return true;
+	}
+	const char *ver(ExplodeAtom::get_start_of_version(name_ver, false));
+	if(unlikely(ver == NULLPTR)) {
 		m_error_callback(eix::format(_("cannot split %r into package and version")) % name_ver);
-		return;
+		return true;
 	}
-	/* Search for existing package */
-	Package *pkg(dest_cat->findPackage(aux[0]));
-
-	/* If none was found create one */
-	if(pkg == NULLPTR) {
-		pkg = dest_cat->addPackage(catarg, aux[0]);
+GCC_DIAG_OFF(sign-conversion)
+	string::size_type name_len((ver - 1) - name_ver);
+GCC_DIAG_ON(sign-conversion)
+	// Usually, all versions of a package are consecutive
+	Package *pkg(query->pkg);
+	if((pkg == NULLPTR) || (pkg->name.compare(0, string::npos, name_ver, name_len) != 0)) {
+		string name(name_ver, name_len);
+		/* Search for existing package */
+		pkg = query->dest_cat->findPackage(name);
+
+		/* If none was found create one */
+		if(pkg == NULLPTR) {
+			pkg = query->dest_cat->addPackage(query->cat_name, name);
+		}
+		query->pkg = pkg;
 	}
 
 	/* Create a new version and add it to package */
 	Version *version(new Version);
 	string errtext;
-	BasicVersion::ParseResult r(version->parseVersion(aux[1], &errtext));
+	BasicVersion::ParseResult r(version->parseVersion(ver, &errtext));
 	if(unlikely(r != BasicVersion::parsedOK)) {
 		m_error_callback(errtext);
 	}
 	if(unlikely(r == BasicVersion::parsedError)) {
 		delete version;
-	} else {
-		// reading slots and stability
-		version->set_slotname(TrueIndex::c_str(argv, &trueindex, TrueIndex::SLOT));
-		version->set_restrict(TrueIndex::c_str(argv, &trueindex, TrueIndex::RESTRICT));
-		version->set_properties(TrueIndex::c_str(argv, &trueindex, TrueIndex::PROPERTIES));
-		version->set_full_keywords(TrueIndex::c_str(argv, &trueindex, TrueIndex::KEYWORDS));
-		version->set_iuse(TrueIndex::c_str(argv, &trueindex, TrueIndex::IUSE));
-		version->depend.set(TrueIndex::c_str(argv, &trueindex, TrueIndex::DEPEND),
-			TrueIndex::c_str(argv, &trueindex, TrueIndex::RDEPEND),
-			TrueIndex::c_str(argv, &trueindex, TrueIndex::PDEPEND),
-			TrueIndex::c_str(argv, &trueindex, TrueIndex::HDEPEND),
-			false);
-		version->overlay_key = m_overlay_key;
-		pkg->addVersion(version);
-
-		/* For the newest version, add all remaining data */
-		if(*(pkg->latest()) == *version) {
-			pkg->homepage = TrueIndex::c_str(argv, &trueindex, TrueIndex::HOMEPAGE);
-			pkg->licenses = TrueIndex::c_str(argv, &trueindex, TrueIndex::LICENSE);
-			pkg->desc     = TrueIndex::c_str(argv, &trueindex, TrueIndex::DESCRIPTION);
-		}
+		return true;
+	}
+	// reading slots and stability
+	version->set_slotname(query->text(stmt, SLOT));
+	version->set_restrict(query->text(stmt, RESTRICT));
+	version->set_properties(query->text(stmt, PROPERTIES));
+	version->set_full_keywords(query->text(stmt, KEYWORDS));
+	version->set_iuse(query->text(stmt, IUSE));
+	version->depend.set(query->text(stmt, DEPEND),
+		query->text(stmt, RDEPEND),
+		query->text(stmt, PDEPEND),
+		query->text(stmt, HDEPEND),
+		false);
+	version->overlay_key = m_overlay_key;
+	pkg->addVersion(version);
+
+	/* For the newest version, add all remaining data */
+	if(*(pkg->latest()) == *version) {
+		pkg->homepage = query->text(stmt, HOMEPAGE);
+		pkg->licenses = query->text(stmt, LICENSE);
+		pkg->desc     = query->text(stmt, DESCRIPTION);
 	}
-	/* Free old split */
-	free(aux[0]);
-	free(aux[1]);
+	return true;
 }
 
+/**
+    The database is opened read-only. Read-only connections take only
+    shared locks, so several categories can be queried concurrently while
+    portage cannot modify the cache under our feet.
+    If only one category is read, only its rows are selected: Since
+    portage_package_key is unique (and thus indexed), this is fast.
+*/
 bool SqliteCache::readCategories(PackageTree *pkgtree, const char *catname, Category *cat) {
-	char *errormessage(NULLPTR);
 	string sqlitefile(m_prefix + PORTAGE_CACHE_PATH + m_scheme);
 	// Cut all trailing '/' and append ".sqlite" to the name
 	string::size_type pos(sqlitefile.find_last_not_of('/'));
@@ -287,26 +266,66 @@ bool SqliteCache::readCategories(PackageTree *pkgtree, const char *catname, Cate
 	sqlitefile.append(".sqlite");
 
 	sqlite3 *db;
-	int rc(sqlite3_open(sqlitefile.c_str(), &db));
-	if(rc) {
+	int rc(sqlite3_open_v2(sqlitefile.c_str(), &db,
+		SQLITE_OPEN_READONLY, NULLPTR));
+	if(rc != SQLITE_OK) {
 		sqlite3_close(db);
 		m_error_callback(eix::format(_("cannot open cache file %s")) % sqlitefile);
 		return false;
 	}
-	callback_arg = this;
-	sqlite_callback_error = false;
-	maxindex = 0;
-	packagetree = pkgtree;
-	category = cat;
-	cat_name = catname;
-	rc = sqlite3_exec(db, "select * from portage_packages", sqlite_callback, NULLPTR, &errormessage);
-	sqlite3_close(db);
-	trueindex.clear();
-	if(rc != SQLITE_OK) {
-		sqlite_callback_error = true;
-		m_error_callback(eix::format(_("sqlite error: %s")) % errormessage);
+	// The bounds of the keys of catname: '0' follows '/' in ASCII
+	string lower, upper;
+	const char *sql;
+	if(pkgtree == NULLPTR) {
+		lower.assign(catname);
+		upper.assign(lower);
+		lower.append(1, '/');
+		upper.append(1, '0');
+		sql = "select * from portage_packages"
+			" where portage_package_key >= ?1 and portage_package_key < ?2";
+	} else {
+		sql = "select * from portage_packages";
+	}
+	sqlite3_stmt *stmt(NULLPTR);
+	rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULLPTR);
+	if(likely(rc == SQLITE_OK) && (pkgtree == NULLPTR)) {
+GCC_DIAG_OFF(old-style-cast)
+		rc = sqlite3_bind_text(stmt, 1, lower.c_str(), -1, SQLITE_STATIC);
+		if(likely(rc == SQLITE_OK)) {
+			rc = sqlite3_bind_text(stmt, 2, upper.c_str(), -1, SQLITE_STATIC);
+		}
+GCC_DIAG_ON(old-style-cast)
 	}
-	return !sqlite_callback_error;
+	bool success(true);
+	if(likely(rc == SQLITE_OK)) {
+		Query query(pkgtree, cat);
+		const char *missing(query.bind_columns(stmt));
+		if(unlikely(missing != NULLPTR)) {
+			success = false;
+			if(query.columns[NAME] < 0) {
+				m_error_callback(_("sqlite dataset does not contain a package name"));
+			} else {
+				m_error_callback(eix::format(_("sqlite dataset has no column %s")) % missing);
+			}
+		} else {
+			while((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+				if(unlikely(!read_row(&query, stmt))) {
+					success = false;
+					break;
+				}
+			}
+			if(likely(success) && unlikely(rc != SQLITE_DONE)) {
+				success = false;
+				m_error_callback(eix::format(_("sqlite error: %s")) % sqlite3_errmsg(db));
+			}
+		}
+	} else {
+		success = false;
+		m_error_callback(eix::format(_("sqlite error: %s")) % sqlite3_errmsg(db));
+	}
+	sqlite3_finalize(stmt);
+	sqlite3_close(db);
+	return success;
 }
 
 #else /* Not WITH_SQLITE */
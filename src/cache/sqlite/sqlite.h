@@ -10,36 +10,20 @@
 #ifndef SRC_CACHE_SQLITE_SQLITE_H_
 #define SRC_CACHE_SQLITE_SQLITE_H_ 1
 
-#include <vector>
-
 #include "cache/base.h"
 
 class Category;
 class PackageTree;
-class TrueIndex;
+struct sqlite3_stmt;
 
 class SqliteCache : public BasicCache {
-		friend int sqlite_callback(void *NotUsed, int argc, char **argv, char **azColName);
-
-	public:  // actually private, but this is too clumsy...
-		typedef std::vector<int> TrueIndexMap;
-
 	private:
 		bool never_add_categories;
-		void sqlite_callback_cpp(int argc, const char **argv, const char **azColName) ATTRIBUTE_NONNULL((4));
-		TrueIndexMap trueindex;
-		int maxindex;
-
-		/** This variable is actually the this-parameter for our sqlite_callback function.
-		    Note that this makes readCategories non-reentrant. */
-		static SqliteCache *callback_arg;
-		/** Our sqlite_callback() will set this to true in case of an error. */
-		bool sqlite_callback_error;
-		/** Parameter passing to sqlite_callback() */
-		PackageTree *packagetree;
-		Category *category;
-		const char *cat_name;
-		static TrueIndex *true_index;
+
+		/// The state of a running query for readCategories
+		class Query;
+
+		bool read_row(Query *query, sqlite3_stmt *stmt) ATTRIBUTE_NONNULL_;
 
 	public:
 		SqliteCache() : BasicCache(), never_add_categories(true) {
@@ -9,18 +9,35 @@
 
 #include <config.h>
 
+#include <cstring>
+
+#include <algorithm>
+#include <iterator>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "database/header.h"
+#include "database/trigrams.h"
 #include "eixTk/filenames.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
 #include "eixTk/stringutils.h"
 #include "portage/extendedversion.h"
+#include "portage/version.h"
 
+using std::back_inserter;
 using std::set;
+using std::set_intersection;
+using std::sort;
 using std::string;
+using std::vector;
+
+static bool shorter_postings(const TrigramPostings *a, const TrigramPostings *b);
+
+static bool shorter_postings(const TrigramPostings *a, const TrigramPostings *b) {
+	return (a->size() < b->size());
+}
 
 const DBHeader::OverlayTest
 	DBHeader::OVTEST_NONE,
@@ -36,7 +53,7 @@ const DBHeader::DBVersion DBHeader::current;
 
 /** Which version we do accept. The list must end with 0 */
 const DBHeader::DBVersion DBHeader::accept[] = {
-	DBHeader::current, 33, 32, 31,
+	DBHeader::current, 38, 37, 36, 35, 34, 33, 32, 31,
 	0
 };
 
@@ -123,6 +140,19 @@ void DBHeader::get_overlay_vector(set<ExtendedVersion::Overlay> *overlayset, con
 	}
 }
 
+void DBHeader::parse_hashs() {
+	iuse_table.clear();
+	iuse_table.reserve(iuse_hash.size());
+	for(StringHash::const_iterator it(iuse_hash.begin());
+		likely(it != iuse_hash.end()); ++it) {
+		iuse_table.push_back(IUse(*it));
+	}
+	slot_table.resize(slot_hash.size());
+	for(StringHash::size_type i(0); likely(i != slot_hash.size()); ++i) {
+		slot_subslot(slot_hash[i], &(slot_table[i].first), &(slot_table[i].second));
+	}
+}
+
 bool DBHeader::isCurrent() const {
 	for(const DBVersion *acc(accept); *acc != 0; ++acc) {
 		if(version == *acc) {
@@ -131,3 +161,71 @@ bool DBHeader::isCurrent() const {
 	}
 	return false;
 }
+
+void DBHeader::select_category(IndexSelection *sel, const string& cat_name) const {
+	for(CategoryIndex::size_type c(0); likely(c != category_index.size()); ++c) {
+		const CategoryIndexEntry& cat(category_index[c]);
+		if(cat.name != cat_name) {
+			continue;
+		}
+		for(PackageIndex::size_type p(0); likely(p != cat.packages.size()); ++p) {
+			sel->push_back(IndexPosition(c, p));
+		}
+		return;
+	}
+}
+
+void DBHeader::select_package(IndexSelection *sel, const char *cat_name, const string& pkg_name) const {
+	for(CategoryIndex::size_type c(0); likely(c != category_index.size()); ++c) {
+		const CategoryIndexEntry& cat(category_index[c]);
+		if((cat_name != NULLPTR) && (strcmp(cat.name.c_str(), cat_name) != 0)) {
+			continue;
+		}
+		for(PackageIndex::size_type p(0); likely(p != cat.packages.size()); ++p) {
+			if(cat.packages[p].name == pkg_name) {
+				sel->push_back(IndexPosition(c, p));
+				break;
+			}
+		}
+	}
+}
+
+bool DBHeader::select_trigrams(IndexSelection *sel, const TrigramSet& trigrams) const {
+	if(!use_trigrams || trigrams.empty() || category_index.empty()) {
+		return false;
+	}
+	// Intersect the postings, starting with the shortest
+	vector<const TrigramPostings *> postings;
+	for(TrigramSet::const_iterator it(trigrams.begin());
+		likely(it != trigrams.end()); ++it) {
+		TrigramIndex::const_iterator found(trigram_index.find(*it));
+		if(unlikely(found == trigram_index.end())) {
+			return false;
+		}
+		postings.push_back(&(found->second));
+	}
+	sort(postings.begin(), postings.end(), shorter_postings);
+	TrigramPostings result(*(postings[0]));
+	for(vector<const TrigramPostings *>::size_type i(1);
+		(i != postings.size()) && !result.empty(); ++i) {
+		TrigramPostings intersection;
+		set_intersection(result.begin(), result.end(),
+			postings[i]->begin(), postings[i]->end(),
+			back_inserter(intersection));
+		result.swap(intersection);
+	}
+	// Convert the package numbers into index positions
+	CategoryIndex::size_type c(0);
+	eix::Treesize first(0);
+	for(TrigramPostings::const_iterator it(result.begin());
+		likely(it != result.end()); ++it) {
+		while(*it >= first + category_index[c].packages.size()) {
+			first += category_index[c].packages.size();
+			if(unlikely(++c == category_index.size())) {
+				return true;
+			}
+		}
+		sel->push_back(IndexPosition(c, *it - first));
+	}
+	return true;
+}
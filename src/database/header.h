@@ -12,16 +12,54 @@
 
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "database/trigrams.h"
 #include "eixTk/constexpr.h"
 #include "eixTk/eixint.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
 #include "portage/extendedversion.h"
 #include "portage/overlay.h"
+#include "portage/version.h"
 
 class PortageSettings;
 
+/** Position of a package block relative to the start of its category block */
+class PackageIndexEntry {
+	public:
+		std::string name;
+		eix::OffsetType offset;
+
+		PackageIndexEntry(const std::string& pkg_name, eix::OffsetType pkg_offset)
+			: name(pkg_name), offset(pkg_offset) {
+		}
+};
+
+typedef std::vector<PackageIndexEntry> PackageIndex;
+
+/** Position of a category block relative to the first category block
+    together with the positions of all its packages */
+class CategoryIndexEntry {
+	public:
+		std::string name;
+		eix::OffsetType offset;
+		PackageIndex packages;
+
+		CategoryIndexEntry(const std::string& cat_name, eix::OffsetType cat_offset)
+			: name(cat_name), offset(cat_offset) {
+		}
+};
+
+typedef std::vector<CategoryIndexEntry> CategoryIndex;
+
+/** A package in the CategoryIndex: index of category and of package */
+typedef std::pair<CategoryIndex::size_type, PackageIndex::size_type> IndexPosition;
+
+/** A list of packages in database order */
+typedef std::vector<IndexPosition> IndexSelection;
+
 /** Representation of a database-header.
  * Contains your arch, the version of the db, the number of packages/categories
  * and a table of key->directory mappings. */
@@ -38,10 +76,49 @@ class DBHeader {
 			slot_hash,
 			depend_hash;
 
+		/** The entries of iuse_hash and of slot_hash (split into slot and
+		    subslot) parsed once so that reading versions needs no parsing;
+		    they are filled by parse_hashs() */
+		std::vector<IUse> iuse_table;
+		std::vector<std::pair<std::string, std::string> > slot_table;
+
+		void parse_hashs();
+
 		bool use_depend;
 
+		/** Is a category index stored in the database? */
+		bool use_index;
+
+		/** The category index; it is only filled by Database::read_index() */
+		CategoryIndex category_index;
+
+		/** Are fingerprints for incremental updates stored in the database? */
+		bool use_fingerprints;
+
+		/** The fingerprint of the eix-update configuration and of the
+		    categories (as far as known); they are only filled by
+		    Database::read_fingerprints() */
+		std::string config_fingerprint;
+		WordMap category_fingerprints;
+
+		/** Is a trigram index of names, descriptions, and homepages stored
+		    in the database? */
+		bool use_trigrams;
+
+		/** The trigram index; it is only filled by Database::read_trigrams()
+		    and contains only the trigrams asked for */
+		TrigramIndex trigram_index;
+
+		/** Where to find the category index, the fingerprints, the trigram
+		    index, and the first category block */
+		eix::OffsetType index_offset, fingerprints_offset, trigrams_offset, tree_offset;
+
 		WordVec world_sets;
 
+		/** The fingerprint of the profile (CascadingProfile::fingerprint())
+		    from which eix-update calculated the stored masks */
+		std::string profile_fingerprint;
+
 		typedef  eix::UNumber DBVersion;
 
 		typedef  eix::UChar OverlayTest;
@@ -58,12 +135,15 @@ class DBHeader {
 		static const char *magic;
 
 		/** Current version of database-format and what we accept */
-		static CONSTEXPR DBVersion current = 34;
+		static CONSTEXPR DBVersion current = 39;
 		static const DBVersion accept[];
 
 		DBVersion version;  /**< Version of the db. */
 		eix::Catsize size;  /**< Number of categories. */
 
+		DBHeader() : use_index(false), use_fingerprints(false), use_trigrams(false) {
+		}
+
 		/** Get overlay for key from table. */
 		const OverlayIdent& getOverlay(ExtendedVersion::Overlay key) const;
 
@@ -93,6 +173,20 @@ class DBHeader {
 		}
 
 		bool isCurrent() const ATTRIBUTE_PURE;
+
+		/** Add all packages of category cat_name to sel.
+		    The category index must have been read. */
+		void select_category(IndexSelection *sel, const std::string& cat_name) const ATTRIBUTE_NONNULL((2));
+
+		/** Add all packages with name pkg_name (in category cat_name or in
+		    any category if cat_name is NULLPTR) to sel.
+		    The category index must have been read. */
+		void select_package(IndexSelection *sel, const char *cat_name, const std::string& pkg_name) const ATTRIBUTE_NONNULL((2));
+
+		/** Add all packages containing all trigrams to sel.
+		    The category index and these trigrams must have been read.
+		    @return false if this is not the case */
+		bool select_trigrams(IndexSelection *sel, const TrigramSet& trigrams) const ATTRIBUTE_NONNULL((2));
 };
 
 #endif  // SRC_DATABASE_HEADER_H_
@@ -8,19 +8,25 @@
 #include <config.h>
 
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 #include <string>
 #include <vector>
 
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
 #ifdef HAVE_SYS_FILE_H
 #include <sys/file.h>
 #endif
 
 #include "database/header.h"
 #include "database/io.h"
-#include "eixTk/auto_list.h"
 #include "eixTk/diagnostics.h"
 #include "eixTk/eixint.h"
+#include "eixTk/formated.h"
 #include "eixTk/i18n.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
@@ -29,7 +35,7 @@
 using std::string;
 using std::vector;
 
-bool File::openread(const char *name) {
+bool File::openread(const char *name, bool use_mmap) {
 	if((fp = fopen(name, "rb")) == NULLPTR) {
 		return false;
 	}
@@ -37,11 +43,88 @@ bool File::openread(const char *name) {
 #ifdef HAVE_FLOCK
 	flock(fileno(fp), LOCK_SH);
 #endif
+#endif
+	if(!use_mmap) {
+		return true;
+	}
+	// We keep fp open (and thus the lock) while the file is mapped.
+	// If mapping fails for whatever reason, we silently fall back to stdio.
+#ifdef HAVE_FILENO
+	struct stat st;
+	int fd(fileno(fp));
+	if(unlikely((fstat(fd, &st) != 0) || (st.st_size <= 0))) {
+		return true;
+	}
+GCC_DIAG_OFF(sign-conversion)
+	void *buffer(mmap(NULLPTR, st.st_size, PROT_READ, MAP_SHARED, fd, 0));
+GCC_DIAG_ON(sign-conversion)
+GCC_DIAG_OFF(old-style-cast)
+	if(unlikely(buffer == MAP_FAILED)) {
+GCC_DIAG_ON(old-style-cast)
+		return true;
+	}
+	map_curr = map_begin = static_cast<const eix::UChar *>(buffer);
+	map_end = map_begin + st.st_size;
 #endif
 	return true;
 }
 
+bool File::openread(const File& mapped) {
+	if(unlikely(!mapped.is_mapped())) {
+		return false;
+	}
+	map_curr = map_begin = mapped.map_begin;
+	map_end = mapped.map_end;
+	map_owner = false;
+	return true;
+}
+
+void File::unmap() {
+	if(map_begin == NULLPTR) {
+		return;
+	}
+	if(!map_owner) {
+		map_begin = map_curr = map_end = NULLPTR;
+		return;
+	}
+GCC_DIAG_OFF(cast-qual)
+	munmap(const_cast<eix::UChar *>(map_begin), map_end - map_begin);
+GCC_DIAG_ON(cast-qual)
+	map_begin = map_curr = map_end = NULLPTR;
+}
+
 bool File::openwrite(const char *name) {
+	struct stat st;
+	bool exists(lstat(name, &st) == 0);
+	if((!exists) || S_ISREG(st.st_mode)) {
+		string tempname(name);
+		tempname.append(".XXXXXX");
+		vector<char> temp(tempname.begin(), tempname.end());
+		temp.push_back('\0');
+		int fd(mkstemp(&(temp[0])));
+		if(likely(fd >= 0)) {
+			mode_t mode;
+			if(exists) {
+				if(unlikely(fchown(fd, st.st_uid, st.st_gid) != 0)) {
+					// Not critical: we might not be allowed to keep the owner
+				}
+				mode = st.st_mode;
+			} else {
+				mode = umask(0);
+				umask(mode);
+				mode = 0666 & ~mode;
+			}
+			fchmod(fd, mode & 07777);
+			if(likely((fp = fdopen(fd, "wb")) != NULLPTR)) {
+				m_name = name;
+				m_tempname = &(temp[0]);
+				return true;
+			}
+			close(fd);
+			unlink(&(temp[0]));
+		}
+		// If we cannot create a file in the directory, write in place
+	}
 	if((fp = fopen(name, "wb")) == NULLPTR) {
 		return false;
 	}
@@ -53,10 +136,39 @@ bool File::openwrite(const char *name) {
 	return true;
 }
 
+bool File::commit(string *errtext) {
+	bool ok(fclose(fp) == 0);
+	fp = NULLPTR;
+	if(m_tempname.empty()) {
+		if(unlikely(!ok) && (errtext != NULLPTR)) {
+			*errtext = _("error when closing the written file");
+		}
+		return ok;
+	}
+	if(likely(ok) &&
+		likely(rename(m_tempname.c_str(), m_name.c_str()) == 0)) {
+		m_tempname.clear();
+		return true;
+	}
+	unlink(m_tempname.c_str());
+	m_tempname.clear();
+	if(errtext != NULLPTR) {
+		*errtext = eix::format(_("cannot replace %r")) % m_name;
+	}
+	return false;
+}
+
 File::~File() {
+	unmap();
 	if(unlikely(fp == NULLPTR)) {
 		return;
 	}
+	if(unlikely(!m_tempname.empty())) {
+		// Not committed: never replace the target by a partial file
+		fclose(fp);
+		unlink(m_tempname.c_str());
+		return;
+	}
 #ifdef HAVE_FILENO
 #ifdef HAVE_FLOCK
 	// do not unlock: fclose(fp) will unlock anyway, and maybe some
@@ -68,12 +180,23 @@ File::~File() {
 }
 
 bool File::seek(eix::OffsetType offset, int whence, std::string *errtext) {
+	if(map_begin != NULLPTR) {
+		eix::OffsetType pos(offset);
+		if(whence == SEEK_CUR) {
+			pos += map_curr - map_begin;
+		}
+		if(likely((pos >= 0) && (pos <= map_end - map_begin))) {
+			map_curr = map_begin + pos;
+			return true;
+		}
+	} else {
 #ifdef HAVE_FSEEKO
-	if(likely(fseeko(fp, offset, whence) == 0))
+		if(likely(fseeko(fp, offset, whence) == 0))
 #else
-	if(likely(fseek(fp, offset, whence) == 0))
+		if(likely(fseek(fp, offset, whence) == 0))
 #endif
-		return true;
+			return true;
+	}
 	if(errtext != NULLPTR) {
 		*errtext = _("fseek failed");
 	}
@@ -81,6 +204,9 @@ bool File::seek(eix::OffsetType offset, int whence, std::string *errtext) {
 }
 
 eix::OffsetType File::tell() {
+	if(map_begin != NULLPTR) {
+		return map_curr - map_begin;
+	}
 #ifdef HAVE_FSEEKO
 	// We rely on autoconf whose documentation states:
 	// All systems with fseeko() also supply ftello()
@@ -90,6 +216,41 @@ eix::OffsetType File::tell() {
 #endif
 }
 
+bool File::read(char *s, string::size_type len) {
+	if(map_begin == NULLPTR) {
+		return (fread(s, sizeof(*s), len, fp) == len);
+	}
+GCC_DIAG_OFF(sign-conversion)
+	if(unlikely(len > string::size_type(map_end - map_curr))) {
+GCC_DIAG_ON(sign-conversion)
+		map_curr = map_end;
+		return false;
+	}
+	memcpy(s, map_curr, len);
+	map_curr += len;
+	return true;
+}
+
+bool File::read_ref(const char **s, string::size_type len) {
+	if(map_begin != NULLPTR) {
+GCC_DIAG_OFF(sign-conversion)
+		if(unlikely(len > string::size_type(map_end - map_curr))) {
+GCC_DIAG_ON(sign-conversion)
+			map_curr = map_end;
+			return false;
+		}
+		*s = reinterpret_cast<const char *>(map_curr);
+		map_curr += len;
+		return true;
+	}
+	ref_buffer.resize(len);
+	if(unlikely((len != 0) && !read(&(ref_buffer[0]), len))) {
+		return false;
+	}
+	*s = ref_buffer.c_str();
+	return true;
+}
+
 bool File::read_string_plain(char *s, string::size_type len, string *errtext) {
 	if(likely(read(s, len))) {
 		return true;
@@ -108,7 +269,7 @@ bool File::write_string_plain(const string& str, string *errtext) {
 
 void File::readError(string *errtext) {
 	if(errtext != NULLPTR) {
-		*errtext = (feof(fp) ?
+		*errtext = (((map_begin != NULLPTR) ? (map_curr == map_end) : feof(fp)) ?
 			_("error while reading from database: end of file") :
 			_("error while reading from database"));
 	}
@@ -150,20 +311,33 @@ GCC_DIAG_ON(sign-conversion)
 	return File::write_string_plain(str, errtext);
 }
 
-bool Database::read_string(string *s, string *errtext) {
-	string::size_type len;
-	if(unlikely(!read_num(&len, errtext))) {
+bool Database::read_string_ref(const char **s, string::size_type *len, string *errtext) {
+	if(unlikely(!read_num(len, errtext))) {
 		return false;
 	}
-	eix::auto_list<char> buf(new char[len + 1]);
-	buf.get()[len] = 0;
-	if(likely(read_string_plain(buf.get(), len, errtext))) {
-		*s = buf.get();
+	if(likely(read_ref(s, *len))) {
 		return true;
 	}
+	readError(errtext);
 	return false;
 }
 
+bool Database::read_string(string *s, string *errtext) {
+	const char *ref;
+	string::size_type len;
+	if(likely(read_string_ref(&ref, &len, errtext))) {
+		s->assign(ref, len);
+		return true;
+	}
+	return false;
+}
+
+bool Database::skip_string(string *errtext) {
+	string::size_type len;
+	return (likely(read_num(&len, errtext)) &&
+		likely(seekrel(len, errtext)));
+}
+
 bool Database::write_string(const string& str, string *errtext) {
 	return (likely(write_num(str.size(), errtext)) &&
 		likely(write_string_plain(str, errtext)));
@@ -12,6 +12,8 @@
 
 #include <string>
 
+#include "database/header.h"
+#include "database/trigrams.h"
 #include "eixTk/diagnostics.h"
 #include "eixTk/eixint.h"
 #include "eixTk/likely.h"
@@ -22,7 +24,7 @@
 // include "portage/basicversion.h" This comment satisfies check_include script
 
 class BasicPart;
-class DBHeader;
+class Category;
 class IUseSet;
 class Package;
 class PackageReader;
@@ -36,28 +38,72 @@ class Version;
 class File {
 	private:
 		FILE *fp;
+
+		/// If the file is mapped, these point into the mapping; otherwise NULLPTR
+		const eix::UChar *map_begin, *map_curr, *map_end;
+
+		/// False if the mapping belongs to another File
+		bool map_owner;
+
+		/// Buffer for read_ref() if the file is not mapped
+		std::string ref_buffer;
+
+		/// If the file is written through a temporary file, the name of
+		/// the file to be replaced and of the temporary file; otherwise empty
+		std::string m_name, m_tempname;
+
 		bool seek(eix::OffsetType offset, int whence, std::string *errtext);
+		void unmap();
 
 	public:
-		File() : fp(NULLPTR) {
+		File() : fp(NULLPTR), map_begin(NULLPTR), map_curr(NULLPTR), map_end(NULLPTR), map_owner(true) {
 		}
 
 		~File();
 
-		bool openread(const char *name) ATTRIBUTE_NONNULL_;
+		/// Open for reading. If possible, the file is mapped into memory;
+		/// otherwise (or if use_mmap is false) stdio is used.
+		bool openread(const char *name, bool use_mmap) ATTRIBUTE_NONNULL_;
+		bool openread(const char *name) ATTRIBUTE_NONNULL_ {
+			return openread(name, true);
+		}
+		/// Share the mapping of the (mapped) file with an own position.
+		/// The mapping must stay valid while this object is used.
+		/// This allows to read the same file in parallel threads.
+		bool openread(const File& mapped);
+		/// Open for writing. If name is a regular file or does not exist,
+		/// a temporary file in the same directory is written instead which
+		/// replaces name only in commit(), so that readers which have the
+		/// old file mapped are not disturbed.
 		bool openwrite(const char *name) ATTRIBUTE_NONNULL_;
 
+		/// Close a file opened with openwrite() and move the temporary file
+		/// (if any) over the target. Without commit(), the temporary file
+		/// is removed by the destructor, and the target is not touched.
+		bool commit(std::string *errtext);
+
+		bool is_mapped() const {
+			return (map_begin != NULLPTR);
+		}
+
 		int getch() {
-			return fgetc(fp);
+			if(map_begin == NULLPTR) {
+				return fgetc(fp);
+			}
+			return (likely(map_curr != map_end) ? *(map_curr++) : EOF);
 		}
 
 		bool putch(eix::UChar c) {
 			return (fputc(c, fp) != EOF);
 		}
 
-		bool read(char *s, std::string::size_type len) {
-			return (fread(s, sizeof(*s), len, fp) == len);
-		}
+		bool read(char *s, std::string::size_type len);
+
+		/// Make *s point to the next len bytes of the file.
+		/// If the file is mapped, no data is copied, and *s points into the
+		/// mapping; otherwise *s points to an internal buffer which is valid
+		/// only until the next call of read_ref().
+		bool read_ref(const char **s, std::string::size_type len) ATTRIBUTE_NONNULL_;
 
 		bool write(const std::string str) {
 			return (fwrite(static_cast<const void *>(str.c_str()), sizeof(*(str.c_str())), str.size(), fp) == str.size());
@@ -82,6 +128,7 @@ class File {
 
 class Database : public File {
 		friend class PackageReader;
+		friend class VarDbIndex;
 
 	private:
 		bool counting;
@@ -102,6 +149,13 @@ class Database : public File {
 		template<typename m_Tp> bool write_num(m_Tp t, std::string *errtext);
 
 		bool read_string(std::string *s, std::string *errtext) ATTRIBUTE_NONNULL((2));
+
+		/// Move the file pointer behind the next string without reading it
+		bool skip_string(std::string *errtext);
+
+		/// Read a string without copying it if the database is mapped.
+		/// *s is not 0-terminated and valid only until the next read_string_ref()
+		bool read_string_ref(const char **s, std::string::size_type *len, std::string *errtext) ATTRIBUTE_NONNULL((2, 3));
 		bool write_string(const std::string& str, std::string *errtext);
 
 		bool write_hash_string(const StringHash& hash, const std::string& s, std::string *errtext) {
@@ -126,7 +180,9 @@ class Database : public File {
 		bool read_hash_words(const StringHash& hash, WordVec *s, std::string *errtext) ATTRIBUTE_NONNULL((3));
 		bool read_hash_words(const StringHash& hash, std::string *s, std::string *errtext) ATTRIBUTE_NONNULL((3));
 
-		bool read_iuse(const StringHash& hash, IUseSet *iuse, std::string *errtext) ATTRIBUTE_NONNULL((3));
+		bool read_iuse(const DBHeader& hdr, IUseSet *iuse, std::string *errtext) ATTRIBUTE_NONNULL((3));
+
+		bool read_slot(const DBHeader& hdr, ExtendedVersion *v, std::string *errtext) ATTRIBUTE_NONNULL((3));
 
 		bool read_version(Version *v, const DBHeader& hdr, std::string *errtext) ATTRIBUTE_NONNULL((2));
 		bool write_version(const Version *v, const DBHeader& hdr, std::string *errtext) ATTRIBUTE_NONNULL((2));
@@ -138,20 +194,54 @@ class Database : public File {
 		bool write_category_header(const std::string& name, eix::Treesize size, std::string *errtext);
 
 		bool write_package(const Package& pkg, const DBHeader& hdr, std::string *errtext);
-		bool write_package_pure(const Package& pkg, const DBHeader& hdr, std::string *errtext);
+		bool write_package_pure(const Package& pkg, const DBHeader& hdr, const std::string& digest, std::string *errtext);
 
 		bool write_hash(const StringHash& hash, std::string *errtext);
 		bool read_hash(StringHash *hash, std::string *errtext) ATTRIBUTE_NONNULL((2));
 
+		bool write_category_index(const CategoryIndex& index, std::string *errtext);
+
+		bool write_fingerprints(const DBHeader& hdr, std::string *errtext);
+
+		bool write_trigram_index(const TrigramIndex& index, std::string *errtext);
+		bool write_trigram_postings(const TrigramPostings& postings, std::string *errtext);
+
 	public:
 		Database() : counting(false), counter(0) {
 		}
 
 		static void prep_header_hashs(DBHeader *hdr, const PackageTree& tree) ATTRIBUTE_NONNULL_;
 
+		/// The steps of prep_header_hashs(); hash_category() can be called
+		/// in parallel threads if each thread uses its own hdr.
+		static void init_header_hashs(DBHeader *hdr) ATTRIBUTE_NONNULL_;
+		static void hash_category(DBHeader *hdr, const Category& cat) ATTRIBUTE_NONNULL_;
+		static void merge_header_hashs(DBHeader *hdr, const DBHeader& other) ATTRIBUTE_NONNULL_;
+		static void finalize_header_hashs(DBHeader *hdr) ATTRIBUTE_NONNULL_;
+
+		/// Calculate the offsets of all categories and packages for the index
+		void prep_category_index(DBHeader *hdr, const PackageTree& tree) ATTRIBUTE_NONNULL_;
+
+		/// Collect the trigrams of names, descriptions, and homepages
+		static void prep_trigram_index(DBHeader *hdr, const PackageTree& tree) ATTRIBUTE_NONNULL_;
+
 		bool write_header(const DBHeader& hdr, std::string *errtext);
 		bool read_header(DBHeader *hdr, std::string *errtext) ATTRIBUTE_NONNULL((2));
 
+		/// Fill hdr->category_index if the database has an index.
+		/// Afterwards, the file pointer is at the first category block again.
+		bool read_index(DBHeader *hdr, std::string *errtext) ATTRIBUTE_NONNULL((2));
+
+		/// Fill the fingerprints of hdr if the database has them.
+		/// Afterwards, the file pointer is at the first category block again.
+		bool read_fingerprints(DBHeader *hdr, std::string *errtext) ATTRIBUTE_NONNULL((2));
+
+		/// Fill hdr->trigram_index with the trigrams of wanted if the
+		/// database has a trigram index. Trigrams which do not occur in
+		/// the database get empty postings.
+		/// Afterwards, the file pointer is at the first category block again.
+		bool read_trigrams(DBHeader *hdr, const TrigramSet& wanted, std::string *errtext) ATTRIBUTE_NONNULL((2));
+
 		bool write_packagetree(const PackageTree& pkg, const DBHeader& hdr, std::string *errtext);
 		bool read_packagetree(PackageTree *tree, const DBHeader& hdr, PortageSettings *ps, std::string *errtext) ATTRIBUTE_NONNULL((2, 4));
 };
@@ -16,6 +16,7 @@
 
 #include "database/header.h"
 #include "database/io.h"
+#include "database/trigrams.h"
 #include "eixTk/auto_list.h"
 #include "eixTk/diagnostics.h"
 #include "eixTk/eixint.h"
@@ -88,6 +89,7 @@ GCC_DIAG_ON(sign-conversion)
 	if(unlikely(!read_hash(&(hdr->slot_hash), errtext))) {
 		return false;
 	}
+	hdr->parse_hashs();
 
 	vector<string>::size_type sets_sz;
 	if(unlikely(!read_num(&sets_sz, errtext))) {
@@ -100,6 +102,11 @@ GCC_DIAG_ON(sign-conversion)
 		}
 		hdr->world_sets.push_back(s);
 	}
+	hdr->profile_fingerprint.clear();
+	if((hdr->version >= 39) &&
+		unlikely(!read_string(&(hdr->profile_fingerprint), errtext))) {
+		return false;
+	}
 
 	eix::UNumber use_dep_num;
 	if(unlikely(!read_num(&use_dep_num, errtext))) {
@@ -120,9 +127,192 @@ GCC_DIAG_ON(sign-conversion)
 			}
 		}
 	}
+
+	// The category index is only read on demand by read_index()
+	hdr->use_index = false;
+	hdr->category_index.clear();
+	if(hdr->version >= 35) {
+		eix::UNumber use_index_num;
+		if(unlikely(!read_num(&use_index_num, errtext))) {
+			return false;
+		}
+		if((hdr->use_index = (use_index_num != 0))) {
+			eix::OffsetType len;
+			if(unlikely(!read_num(&len, errtext))) {
+				return false;
+			}
+			hdr->index_offset = tell();
+			if(unlikely(!seekrel(len, errtext))) {
+				return false;
+			}
+		}
+	}
+	// The fingerprints are only read on demand by read_fingerprints()
+	hdr->use_fingerprints = false;
+	hdr->config_fingerprint.clear();
+	hdr->category_fingerprints.clear();
+	if(hdr->version >= 36) {
+		eix::UNumber use_fingerprints_num;
+		if(unlikely(!read_num(&use_fingerprints_num, errtext))) {
+			return false;
+		}
+		if((hdr->use_fingerprints = (use_fingerprints_num != 0))) {
+			eix::OffsetType len;
+			if(unlikely(!read_num(&len, errtext))) {
+				return false;
+			}
+			hdr->fingerprints_offset = tell();
+			if(unlikely(!seekrel(len, errtext))) {
+				return false;
+			}
+		}
+	}
+	// The trigram index is only read on demand by read_trigrams()
+	hdr->use_trigrams = false;
+	hdr->trigram_index.clear();
+	if(hdr->version >= 37) {
+		eix::UNumber use_trigrams_num;
+		if(unlikely(!read_num(&use_trigrams_num, errtext))) {
+			return false;
+		}
+		if((hdr->use_trigrams = (use_trigrams_num != 0))) {
+			eix::OffsetType len;
+			if(unlikely(!read_num(&len, errtext))) {
+				return false;
+			}
+			hdr->trigrams_offset = tell();
+			if(unlikely(!seekrel(len, errtext))) {
+				return false;
+			}
+		}
+	}
+	hdr->tree_offset = tell();
 	return true;
 }
 
+bool Database::read_index(DBHeader *hdr, string *errtext) {
+	CategoryIndex& index(hdr->category_index);
+	index.clear();
+	if(!hdr->use_index) {
+		return true;
+	}
+	if(unlikely(!seekabs(hdr->index_offset, errtext))) {
+		return false;
+	}
+	CategoryIndex::size_type cat_sz;
+	if(unlikely(!read_num(&cat_sz, errtext))) {
+		return false;
+	}
+	index.reserve(cat_sz);
+	for(; likely(cat_sz != 0); --cat_sz) {
+		string name;
+		if(unlikely(!read_string(&name, errtext))) {
+			return false;
+		}
+		eix::OffsetType offset;
+		if(unlikely(!read_num(&offset, errtext))) {
+			return false;
+		}
+		index.push_back(CategoryIndexEntry(name, offset));
+		PackageIndex& packages(index.back().packages);
+		PackageIndex::size_type pkg_sz;
+		if(unlikely(!read_num(&pkg_sz, errtext))) {
+			return false;
+		}
+		packages.reserve(pkg_sz);
+		for(; likely(pkg_sz != 0); --pkg_sz) {
+			if(unlikely(!read_string(&name, errtext))) {
+				return false;
+			}
+			if(unlikely(!read_num(&offset, errtext))) {
+				return false;
+			}
+			packages.push_back(PackageIndexEntry(name, offset));
+		}
+	}
+	return seekabs(hdr->tree_offset, errtext);
+}
+
+bool Database::read_fingerprints(DBHeader *hdr, string *errtext) {
+	hdr->config_fingerprint.clear();
+	WordMap& fingerprints(hdr->category_fingerprints);
+	fingerprints.clear();
+	if(!hdr->use_fingerprints) {
+		return true;
+	}
+	if(unlikely(!seekabs(hdr->fingerprints_offset, errtext))) {
+		return false;
+	}
+	if(unlikely(!read_string(&(hdr->config_fingerprint), errtext))) {
+		return false;
+	}
+	WordMap::size_type cat_sz;
+	if(unlikely(!read_num(&cat_sz, errtext))) {
+		return false;
+	}
+	for(; likely(cat_sz != 0); --cat_sz) {
+		string name;
+		if(unlikely(!read_string(&name, errtext))) {
+			return false;
+		}
+		if(unlikely(!read_string(&(fingerprints[name]), errtext))) {
+			return false;
+		}
+	}
+	return seekabs(hdr->tree_offset, errtext);
+}
+
+bool Database::read_trigrams(DBHeader *hdr, const TrigramSet& wanted, string *errtext) {
+	TrigramIndex& index(hdr->trigram_index);
+	index.clear();
+	if(!hdr->use_trigrams) {
+		return true;
+	}
+	if(unlikely(!seekabs(hdr->trigrams_offset, errtext))) {
+		return false;
+	}
+	TrigramIndex::size_type sz;
+	if(unlikely(!read_num(&sz, errtext))) {
+		return false;
+	}
+	for(; likely(sz != 0); --sz) {
+		Trigram trigram;
+		if(unlikely(!read_num(&trigram, errtext))) {
+			return false;
+		}
+		eix::OffsetType len;
+		if(unlikely(!read_num(&len, errtext))) {
+			return false;
+		}
+		if(wanted.find(trigram) == wanted.end()) {
+			if(unlikely(!seekrel(len, errtext))) {
+				return false;
+			}
+			continue;
+		}
+		TrigramPostings& postings(index[trigram]);
+		TrigramPostings::size_type count;
+		if(unlikely(!read_num(&count, errtext))) {
+			return false;
+		}
+		postings.reserve(count);
+		// The numbers are stored as differences to their predecessors
+		eix::Treesize curr(0);
+		for(; likely(count != 0); --count) {
+			eix::Treesize diff;
+			if(unlikely(!read_num(&diff, errtext))) {
+				return false;
+			}
+			postings.push_back(curr += diff);
+		}
+	}
+	for(TrigramSet::const_iterator it(wanted.begin());
+		likely(it != wanted.end()); ++it) {
+		index[*it];
+	}
+	return seekabs(hdr->tree_offset, errtext);
+}
+
 bool Database::read_hash(StringHash *hash, string *errtext) {
 	hash->init(false);
 	StringHash::size_type i;
@@ -12,9 +12,11 @@
 #include "database/header.h"
 #include "database/io.h"
 #include "database/package_reader.h"
-#include "eixTk/auto_list.h"
+#include "database/trigrams.h"
 #include "eixTk/diagnostics.h"
+#include "eixTk/digest.h"
 #include "eixTk/eixint.h"
+#include "eixTk/i18n.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
 #include "eixTk/stringutils.h"
@@ -30,6 +32,9 @@
 
 using std::string;
 
+static void hash_error(string *errtext);
+static string package_digest(const Package& pkg);
+
 #define WRITE_COUNTER(f) do { \
 	eix::OffsetType counter_save(counter); \
 	counter = 0; \
@@ -52,31 +57,56 @@ bool Database::read_Part(BasicPart *b, string *errtext) {
 	BasicPart::PartType type(BasicPart::PartType(len % BasicPart::max_type));
 	len /= BasicPart::max_type;
 	if(len != 0) {
-		eix::auto_list<char> buf(new char[len + 1]);
-		buf.get()[len] = 0;
-		if(unlikely(!read_string_plain(buf.get(), len, errtext))) {
+		const char *ref;
+		if(unlikely(!read_ref(&ref, len))) {
+			readError(errtext);
 			return false;
 		}
-		*b = BasicPart(type, string(buf.get()));
+		*b = BasicPart(type, string(ref, len));
 		return true;
 	}
 	*b = BasicPart(type);
 	return true;
 }
 
-bool Database::read_iuse(const StringHash& hash, IUseSet *iuse, string *errtext) {
+static void hash_error(string *errtext) {
+	if(errtext != NULLPTR) {
+		*errtext = _("database corrupt: nonexistent hash required");
+	}
+}
+
+bool Database::read_iuse(const DBHeader& hdr, IUseSet *iuse, string *errtext) {
 	iuse->clear();
 	eix::UNumber e;
 	if(unlikely(!read_num(&e, errtext))) {
 		return false;
 	}
 	for(; e; --e) {
-		string s;
-		if(unlikely(!read_hash_string(hash, &s, errtext))) {
+		StringHash::size_type i;
+		if(unlikely(!read_num(&i, errtext))) {
+			return false;
+		}
+		if(unlikely(i >= hdr.iuse_table.size())) {
+			hash_error(errtext);
 			return false;
 		}
-		iuse->insert_fast(s);
+		// The database stores the flags sorted
+		iuse->push_back(hdr.iuse_table[i]);
+	}
+	return true;
+}
+
+bool Database::read_slot(const DBHeader& hdr, ExtendedVersion *v, string *errtext) {
+	StringHash::size_type i;
+	if(unlikely(!read_num(&i, errtext))) {
+		return false;
+	}
+	if(unlikely(i >= hdr.slot_table.size())) {
+		hash_error(errtext);
+		return false;
 	}
+	v->slotname = hdr.slot_table[i].first;
+	v->subslotname = hdr.slot_table[i].second;
 	return true;
 }
 
@@ -102,6 +132,7 @@ bool Database::read_version(Version *v, const DBHeader& hdr, string *errtext) {
 	if(unlikely(!read_num(&i, errtext))) {
 		return false;
 	}
+	v->m_parts.reserve(i);
 	for(; likely(i != 0); --i) {
 		BasicPart b;
 		if(unlikely(!read_Part(&b, errtext))) {
@@ -109,12 +140,11 @@ bool Database::read_version(Version *v, const DBHeader& hdr, string *errtext) {
 		}
 		v->m_parts.push_back(b);
 	}
+	v->calc_sortkey();
 
-	string fullslot;
-	if(unlikely(!read_hash_string(hdr.slot_hash, &fullslot, errtext))) {
+	if(unlikely(!read_slot(hdr, v, errtext))) {
 		return false;
 	}
-	v->set_slotname(fullslot);
 	if(unlikely(!read_num(&(v->overlay_key), errtext))) {
 		return false;
 	}
@@ -122,7 +152,7 @@ bool Database::read_version(Version *v, const DBHeader& hdr, string *errtext) {
 	v->reponame = overlay.label;
 	v->priority = overlay.priority;
 
-	if(unlikely(!read_iuse(hdr.iuse_hash, &(v->iuse), errtext))) {
+	if(unlikely(!read_iuse(hdr, &(v->iuse), errtext))) {
 		return false;
 	}
 
@@ -245,7 +275,23 @@ bool Database::write_category_header(const string& name, eix::Treesize size, str
 		likely(write_num(size, errtext)));
 }
 
-bool Database::write_package_pure(const Package& pkg, const DBHeader& hdr, string *errtext) {
+/** The digest of a package covers everything of its versions from which
+    eix-diff decides whether the package has changed */
+static string package_digest(const Package& pkg) {
+	Digest digest;
+	for(Package::const_iterator it(pkg.begin()); likely(it != pkg.end()); ++it) {
+		digest.add(it->getFull());
+		digest.add(it->get_shortfullslot());
+		digest.add(it->get_full_keywords());
+		digest.add(it->overlay_key);
+		digest.add(it->maskflags.get());
+		digest.add(it->propertiesFlags);
+		digest.add(it->restrictFlags);
+	}
+	return digest.get();
+}
+
+bool Database::write_package_pure(const Package& pkg, const DBHeader& hdr, const string& digest, string *errtext) {
 	if(unlikely(!write_string(pkg.name, errtext))) {
 		return false;
 	}
@@ -258,6 +304,9 @@ bool Database::write_package_pure(const Package& pkg, const DBHeader& hdr, strin
 	if(unlikely(!write_hash_string(hdr.license_hash, pkg.licenses, errtext))) {
 		return false;
 	}
+	if(unlikely(!write_string(digest, errtext))) {
+		return false;
+	}
 
 	// write all version entries
 	if(unlikely(!write_num(pkg.size(), errtext))) {
@@ -273,8 +322,9 @@ bool Database::write_package_pure(const Package& pkg, const DBHeader& hdr, strin
 }
 
 bool Database::write_package(const Package& pkg, const DBHeader& hdr, string *errtext) {
-	WRITE_COUNTER(write_package_pure(pkg, hdr, NULLPTR));
-	return write_package_pure(pkg, hdr, errtext);
+	string digest(package_digest(pkg));
+	WRITE_COUNTER(write_package_pure(pkg, hdr, digest, NULLPTR));
+	return write_package_pure(pkg, hdr, digest, errtext);
 }
 
 bool Database::write_hash(const StringHash& hash, string *errtext) {
@@ -291,6 +341,14 @@ bool Database::write_hash(const StringHash& hash, string *errtext) {
 }
 
 void Database::prep_header_hashs(DBHeader *hdr, const PackageTree& tree) {
+	init_header_hashs(hdr);
+	for(PackageTree::const_iterator c(tree.begin()); likely(c != tree.end()); ++c) {
+		hash_category(hdr, *(c->second));
+	}
+	finalize_header_hashs(hdr);
+}
+
+void Database::init_header_hashs(DBHeader *hdr) {
 	hdr->license_hash.init(true);
 	hdr->keywords_hash.init(true);
 	hdr->slot_hash.init(true);
@@ -300,29 +358,43 @@ void Database::prep_header_hashs(DBHeader *hdr, const PackageTree& tree) {
 	if(use_dep) {
 		hdr->depend_hash.init(true);
 	}
-	for(PackageTree::const_iterator c(tree.begin()); likely(c != tree.end()); ++c) {
-		Category *ci(c->second);
-		for(Category::iterator p(ci->begin()); likely(p != ci->end()); ++p) {
-			hdr->license_hash.hash_string(p->licenses);
-			for(Package::iterator v(p->begin()); likely(v != p->end()); ++v) {
-				hdr->keywords_hash.hash_words(v->get_full_keywords());
-				hdr->iuse_hash.hash_words(v->iuse.asVector());
-				hdr->slot_hash.hash_string(v->get_shortfullslot());
-				if(use_dep) {
-					const Depend& dep(v->depend);
-					hdr->depend_hash.hash_words(dep.m_depend);
-					hdr->depend_hash.hash_words(dep.m_rdepend);
-					hdr->depend_hash.hash_words(dep.m_pdepend);
-					hdr->depend_hash.hash_words(dep.m_hdepend);
-				}
+}
+
+void Database::hash_category(DBHeader *hdr, const Category& cat) {
+	bool use_dep(hdr->use_depend);
+	for(Category::const_iterator p(cat.begin()); likely(p != cat.end()); ++p) {
+		hdr->license_hash.hash_string(p->licenses);
+		for(Package::const_iterator v(p->begin()); likely(v != p->end()); ++v) {
+			hdr->keywords_hash.hash_words(v->get_full_keywords());
+			hdr->iuse_hash.hash_words(v->iuse.asVector());
+			hdr->slot_hash.hash_string(v->get_shortfullslot());
+			if(use_dep) {
+				const Depend& dep(v->depend);
+				hdr->depend_hash.hash_words(dep.m_depend);
+				hdr->depend_hash.hash_words(dep.m_rdepend);
+				hdr->depend_hash.hash_words(dep.m_pdepend);
+				hdr->depend_hash.hash_words(dep.m_hdepend);
 			}
 		}
 	}
+}
+
+void Database::merge_header_hashs(DBHeader *hdr, const DBHeader& other) {
+	hdr->license_hash.hash_merge(other.license_hash);
+	hdr->keywords_hash.hash_merge(other.keywords_hash);
+	hdr->slot_hash.hash_merge(other.slot_hash);
+	hdr->iuse_hash.hash_merge(other.iuse_hash);
+	if(hdr->use_depend) {
+		hdr->depend_hash.hash_merge(other.depend_hash);
+	}
+}
+
+void Database::finalize_header_hashs(DBHeader *hdr) {
 	hdr->license_hash.finalize();
 	hdr->keywords_hash.finalize();
 	hdr->slot_hash.finalize();
 	hdr->iuse_hash.finalize();
-	if(use_dep) {
+	if(hdr->use_depend) {
 		hdr->depend_hash.finalize();
 	}
 }
@@ -372,16 +444,125 @@ bool Database::write_header(const DBHeader& hdr, string *errtext) {
 			return false;
 		}
 	}
+	if(unlikely(!write_string(hdr.profile_fingerprint, errtext))) {
+		return false;
+	}
 
 	if(hdr.use_depend) {
 		if(unlikely(!write_num(1, errtext))) {
 			return false;
 		}
 		WRITE_COUNTER(write_hash(hdr.depend_hash, NULLPTR));
-		return write_hash(hdr.depend_hash, errtext);
-	} else {
-		return write_num(0, errtext);
+		if(unlikely(!write_hash(hdr.depend_hash, errtext))) {
+			return false;
+		}
+	} else if(unlikely(!write_num(0, errtext))) {
+		return false;
+	}
+
+	if(hdr.use_index) {
+		if(unlikely(!write_num(1, errtext))) {
+			return false;
+		}
+		WRITE_COUNTER(write_category_index(hdr.category_index, NULLPTR));
+		if(unlikely(!write_category_index(hdr.category_index, errtext))) {
+			return false;
+		}
+	} else if(unlikely(!write_num(0, errtext))) {
+		return false;
+	}
+
+	if(hdr.use_fingerprints) {
+		if(unlikely(!write_num(1, errtext))) {
+			return false;
+		}
+		WRITE_COUNTER(write_fingerprints(hdr, NULLPTR));
+		if(unlikely(!write_fingerprints(hdr, errtext))) {
+			return false;
+		}
+	} else if(unlikely(!write_num(0, errtext))) {
+		return false;
+	}
+
+	if(hdr.use_trigrams) {
+		if(unlikely(!write_num(1, errtext))) {
+			return false;
+		}
+		WRITE_COUNTER(write_trigram_index(hdr.trigram_index, NULLPTR));
+		return write_trigram_index(hdr.trigram_index, errtext);
 	}
+	return write_num(0, errtext);
+}
+
+void Database::prep_category_index(DBHeader *hdr, const PackageTree& tree) {
+	CategoryIndex& index(hdr->category_index);
+	index.clear();
+	hdr->use_index = true;
+	eix::OffsetType counter_save(counter);
+	bool counting_save(counting);
+	counting = true;
+	counter = 0;
+	for(PackageTree::const_iterator c(tree.begin()); likely(c != tree.end()); ++c) {
+		Category *ci(c->second);
+		index.push_back(CategoryIndexEntry(c->first, counter));
+		CategoryIndexEntry& entry(index.back());
+		eix::OffsetType cat_start(counter);
+		write_category_header(c->first, eix::Treesize(ci->size()), NULLPTR);
+		entry.packages.reserve(ci->size());
+		for(Category::iterator p(ci->begin()); likely(p != ci->end()); ++p) {
+			entry.packages.push_back(PackageIndexEntry(p->name, counter - cat_start));
+			write_package(**p, *hdr, NULLPTR);
+		}
+	}
+	counting = counting_save;
+	counter = counter_save;
+}
+
+bool Database::write_category_index(const CategoryIndex& index, string *errtext) {
+	if(unlikely(!write_num(index.size(), errtext))) {
+		return false;
+	}
+	for(CategoryIndex::const_iterator c(index.begin()); likely(c != index.end()); ++c) {
+		if(unlikely(!write_string(c->name, errtext))) {
+			return false;
+		}
+		if(unlikely(!write_num(c->offset, errtext))) {
+			return false;
+		}
+		if(unlikely(!write_num(c->packages.size(), errtext))) {
+			return false;
+		}
+		for(PackageIndex::const_iterator p(c->packages.begin());
+			likely(p != c->packages.end()); ++p) {
+			if(unlikely(!write_string(p->name, errtext))) {
+				return false;
+			}
+			if(unlikely(!write_num(p->offset, errtext))) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+bool Database::write_fingerprints(const DBHeader& hdr, string *errtext) {
+	if(unlikely(!write_string(hdr.config_fingerprint, errtext))) {
+		return false;
+	}
+	const WordMap& fingerprints(hdr.category_fingerprints);
+	if(unlikely(!write_num(fingerprints.size(), errtext))) {
+		return false;
+	}
+	for(WordMap::const_iterator it(fingerprints.begin());
+		likely(it != fingerprints.end()); ++it) {
+		if(unlikely(!write_string(it->first, errtext))) {
+			return false;
+		}
+		if(unlikely(!write_string(it->second, errtext))) {
+			return false;
+		}
+	}
+	return true;
 }
 
 bool Database::write_packagetree(const PackageTree& tree, const DBHeader& hdr, string *errtext) {
@@ -419,3 +600,57 @@ bool Database::read_packagetree(PackageTree *tree, const DBHeader& hdr, PortageS
 	}
 	return false;
 }
+
+void Database::prep_trigram_index(DBHeader *hdr, const PackageTree& tree) {
+	TrigramIndex& index(hdr->trigram_index);
+	index.clear();
+	hdr->use_trigrams = true;
+	eix::Treesize number(0);
+	for(PackageTree::const_iterator c(tree.begin()); likely(c != tree.end()); ++c) {
+		Category *ci(c->second);
+		for(Category::iterator p(ci->begin()); likely(p != ci->end()); ++p, ++number) {
+			TrigramSet trigrams;
+			add_trigrams(&trigrams, p->name);
+			add_trigrams(&trigrams, p->desc);
+			add_trigrams(&trigrams, p->homepage);
+			for(TrigramSet::const_iterator it(trigrams.begin());
+				likely(it != trigrams.end()); ++it) {
+				// Packages are visited in database order, so postings are sorted
+				index[*it].push_back(number);
+			}
+		}
+	}
+}
+
+bool Database::write_trigram_index(const TrigramIndex& index, string *errtext) {
+	if(unlikely(!write_num(index.size(), errtext))) {
+		return false;
+	}
+	for(TrigramIndex::const_iterator it(index.begin());
+		likely(it != index.end()); ++it) {
+		if(unlikely(!write_num(it->first, errtext))) {
+			return false;
+		}
+		WRITE_COUNTER(write_trigram_postings(it->second, NULLPTR));
+		if(unlikely(!write_trigram_postings(it->second, errtext))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Database::write_trigram_postings(const TrigramPostings& postings, string *errtext) {
+	if(unlikely(!write_num(postings.size(), errtext))) {
+		return false;
+	}
+	// Store differences to the predecessor which are mostly small numbers
+	eix::Treesize prev(0);
+	for(TrigramPostings::const_iterator it(postings.begin());
+		likely(it != postings.end()); ++it) {
+		if(unlikely(!write_num(*it - prev, errtext))) {
+			return false;
+		}
+		prev = *it;
+	}
+	return true;
+}
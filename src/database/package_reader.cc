@@ -9,6 +9,7 @@
 
 #include <config.h>
 
+#include "database/header.h"
 #include "database/io.h"
 #include "database/package_reader.h"
 #include "eixTk/eixint.h"
@@ -18,89 +19,140 @@
 #include "portage/package.h"
 #include "portage/version.h"
 
+const PackageReader::Attributes
+	PackageReader::NONE,
+	PackageReader::NAME,
+	PackageReader::DESCRIPTION,
+	PackageReader::HOMEPAGE,
+	PackageReader::LICENSE,
+	PackageReader::DIGEST,
+	PackageReader::VERSIONS,
+	PackageReader::ALL;
+
+const PackageReader::FieldNum
+	PackageReader::NAME_FIELD,
+	PackageReader::DESCRIPTION_FIELD,
+	PackageReader::HOMEPAGE_FIELD,
+	PackageReader::LICENSE_FIELD,
+	PackageReader::DIGEST_FIELD,
+	PackageReader::VERSIONS_FIELD,
+	PackageReader::FIELD_COUNT;
+
 PackageReader::~PackageReader() {
 	delete m_pkg;
 }
 
 bool PackageReader::read(Attributes need) {
-	if(likely(m_have >= need)) {  // Already got this one
-		return true;
+	Attributes missing(static_cast<Attributes>(need & ~m_have));
+	// Field i corresponds to bit i of Attributes
+	for(FieldNum i(0); missing != NONE; ++i) {
+		Attributes bit(1U << i);
+		if((missing & bit) == NONE) {
+			continue;
+		}
+		if(unlikely(!seek_field(i) || !read_field(i))) {
+			m_error = true;
+			return false;
+		}
+		m_have |= bit;
+		missing &= ~bit;
+		if((m_known_offsets == i + 1) && (i + 1 != FIELD_COUNT)) {
+			m_offsets[m_known_offsets++] = m_db->tell();
+		}
 	}
+	return true;
+}
 
-	switch(m_have) {
-		case NONE:
-			if(unlikely(!m_db->read_string(&(m_pkg->name), &m_errtext))) {
-				m_error = true;
-				return false;
-			}
-			if(unlikely(need == NAME))
-				break;
-		case NAME:
-			if(unlikely(!m_db->read_string(&(m_pkg->desc), &m_errtext))) {
-				m_error = true;
-				return false;
-			}
-			if(unlikely(need == DESCRIPTION))
-				break;
-		case DESCRIPTION:
-			if(unlikely(!m_db->read_string(&(m_pkg->homepage), &m_errtext))) {
-				m_error = true;
+bool PackageReader::seek_field(FieldNum i) {
+	if(i < m_known_offsets) {
+		return ((m_db->tell() == m_offsets[i]) ||
+			m_db->seekabs(m_offsets[i], &m_errtext));
+	}
+	// Skip the fields between the last known offset and field i
+	FieldNum j(m_known_offsets - 1);
+	if(unlikely((m_db->tell() != m_offsets[j]) &&
+		!m_db->seekabs(m_offsets[j], &m_errtext))) {
+		return false;
+	}
+	for(; j != i; ++j) {
+		if(j == LICENSE_FIELD) {
+			StringHash::size_type dummy;
+			if(unlikely(!m_db->read_num(&dummy, &m_errtext))) {
 				return false;
 			}
-			if(unlikely(need == HOMEPAGE))
-				break;
-		case HOMEPAGE:
-			if(unlikely(!m_db->read_hash_string(header->license_hash, &(m_pkg->licenses), &m_errtext))) {
-				m_error = true;
+		} else if(j == DIGEST_FIELD) {
+			if(unlikely((header->version >= 38) && !m_db->skip_string(&m_errtext))) {
 				return false;
 			}
-			if(unlikely(need == LICENSE))
-				break;
-		case LICENSE: {
-				eix::Versize i;
-				if(unlikely(!m_db->read_num(&i, &m_errtext))) {
-					m_error = true;
-					return false;
-				}
-				for(; likely(i != 0); --i) {
-					Version *v(new Version());
-					if(unlikely(!m_db->read_version(v, *header, &m_errtext))) {
-						m_error = true;
-						return false;
-					}
-					m_pkg->addVersion(v);
-				}
-			}
-			if(likely(m_portagesettings != NULLPTR)) {
-				m_portagesettings->calc_local_sets(m_pkg);
-				m_portagesettings->finalize(m_pkg);
-			} else {
-				m_pkg->finalize_masks();
-			}
-			m_pkg->save_maskflags(Version::SAVEMASK_FILE);
-		default:
-		// case ALL:
-			break;
+		} else if(unlikely(!m_db->skip_string(&m_errtext))) {
+			return false;
+		}
+		m_offsets[m_known_offsets++] = m_db->tell();
 	}
-	m_have = need;
 	return true;
 }
 
-bool PackageReader::skip() {
-	// only seek if needed
-	if(m_have != ALL) {
-		if(unlikely(!m_db->seekabs(m_next, &m_errtext))) {
-			m_error = true;
+bool PackageReader::read_field(FieldNum i) {
+	switch(i) {
+		case NAME_FIELD:
+			return m_db->read_string(&(m_pkg->name), &m_errtext);
+		case DESCRIPTION_FIELD:
+			return m_db->read_string(&(m_pkg->desc), &m_errtext);
+		case HOMEPAGE_FIELD:
+			return m_db->read_string(&(m_pkg->homepage), &m_errtext);
+		case LICENSE_FIELD:
+			return m_db->read_hash_string(header->license_hash, &(m_pkg->licenses), &m_errtext);
+		case DIGEST_FIELD:
+			if(header->version < 38) {
+				m_digest.clear();
+				return true;
+			}
+			return m_db->read_string(&m_digest, &m_errtext);
+		default:
+			break;
+	}
+	eix::Versize n;
+	if(unlikely(!m_db->read_num(&n, &m_errtext))) {
+		return false;
+	}
+	for(; likely(n != 0); --n) {
+		Version *v(new Version());
+		if(unlikely(!m_db->read_version(v, *header, &m_errtext))) {
+			delete v;
 			return false;
 		}
+		m_pkg->addVersion(v);
 	}
+	// The name has been read before (VERSIONS contains NAME)
+	if(likely(m_portagesettings != NULLPTR)) {
+		m_portagesettings->calc_local_sets(m_pkg);
+		m_portagesettings->finalize(m_pkg);
+	} else {
+		m_pkg->finalize_masks();
+	}
+	m_pkg->save_maskflags(Version::SAVEMASK_FILE);
 	return true;
 }
 
+bool PackageReader::seek_next() {
+	if(likely(m_db->tell() == m_next)) {
+		return true;
+	}
+	if(likely(m_db->seekabs(m_next, &m_errtext))) {
+		return true;
+	}
+	m_error = true;
+	return false;
+}
+
+bool PackageReader::skip() {
+	return seek_next();
+}
+
 /// Release the package.
 // Complete the current package, and release it.
 Package *PackageReader::release() {
-	if(unlikely(!read())) {
+	if(unlikely(!read()) || unlikely(!seek_next())) {
 		return NULLPTR;
 	}
 	Package *r(m_pkg);
@@ -109,7 +161,19 @@ Package *PackageReader::release() {
 }
 
 bool PackageReader::next() {
-	if(unlikely(m_cat_size-- == 0)) {
+	if(m_selection != NULLPTR) {
+		if(unlikely(m_sel_pos == m_selection->size())) {
+			return false;
+		}
+		const IndexPosition& pos((*m_selection)[m_sel_pos++]);
+		const CategoryIndexEntry& cat(header->category_index[pos.first]);
+		if(unlikely(!m_db->seekabs(header->tree_offset + cat.offset +
+			cat.packages[pos.second].offset, &m_errtext))) {
+			m_error = true;
+			return false;
+		}
+		m_cat_name = cat.name;
+	} else if(unlikely(m_cat_size-- == 0)) {
 		if(unlikely(m_frames-- == 0)) {
 			return false;
 		}
@@ -125,7 +189,9 @@ bool PackageReader::next() {
 		m_error = true;
 		return false;
 	}
-	m_next = m_db->tell() + len;
+	m_offsets[0] = m_db->tell();
+	m_known_offsets = 1;
+	m_next = m_offsets[0] + len;
 	m_have = NONE;
 	delete m_pkg;
 	m_pkg = new Package;
@@ -140,28 +206,39 @@ bool PackageReader::nextCategory() {
 	}
 
 	if(likely(m_db->read_category_header(&m_cat_name, &m_cat_size, &m_errtext))) {
+		m_cat_total = m_cat_size;
+		m_cat_offset = m_db->tell();
+		return true;
+	}
+	m_error = true;
+	return false;
+}
+
+bool PackageReader::restartCategory() {
+	if(likely(m_db->seekabs(m_cat_offset, &m_errtext))) {
+		m_cat_size = m_cat_total;
 		return true;
 	}
 	m_error = true;
 	return false;
 }
 
-bool PackageReader::nextPackage() {
+bool PackageReader::nextPackage(Attributes need) {
 	if(unlikely(m_cat_size-- == 0)) {
 		return false;
 	}
 
-	/* Ignore the offset and read the whole package at once.
-	 */
-
-	eix::OffsetType dummy;
-	if(unlikely(!m_db->read_num(&dummy, &m_errtext))) {
+	eix::OffsetType len;
+	if(unlikely(!m_db->read_num(&len, &m_errtext))) {
 		m_error = true;
 		return false;
 	}
+	m_offsets[0] = m_db->tell();
+	m_known_offsets = 1;
+	m_next = m_offsets[0] + len;
 	m_have = NONE;
 	delete m_pkg;
 	m_pkg = new Package;
 	m_pkg->category = m_cat_name;
-	return read(ALL);
+	return read(need);
 }
@@ -16,36 +16,55 @@
 #include <string>
 
 #include "database/header.h"
+#include "eixTk/constexpr.h"
 #include "eixTk/eixint.h"
 #include "eixTk/null.h"
 
 class Database;
-class DBHeader;
 class Package;
 class PortageSettings;
 
 /// Forward-iterate for packages stored in the cachefile.
 class PackageReader {
 	public:
-		enum Attributes {
-			NONE = 0,
-			NAME, DESCRIPTION, HOMEPAGE, LICENSE, VERSIONS,
-			ALL = 7
-		};
+		/// The numbers of the fields of a package in database order
+		typedef unsigned int FieldNum;
+		static CONSTEXPR FieldNum
+			NAME_FIELD        = 0,
+			DESCRIPTION_FIELD = 1,
+			HOMEPAGE_FIELD    = 2,
+			LICENSE_FIELD     = 3,
+			DIGEST_FIELD      = 4,
+			VERSIONS_FIELD    = 5,
+			FIELD_COUNT       = 6;
+
+		/// The fields of a package. They can be read in any combination;
+		/// the fields which are not needed are skipped without decoding.
+		/// Field i corresponds to bit i.
+		typedef eix::TinyUnsigned Attributes;
+		static CONSTEXPR Attributes
+			NONE        = 0x00U,
+			NAME        = 1U << NAME_FIELD,
+			DESCRIPTION = 1U << DESCRIPTION_FIELD,
+			HOMEPAGE    = 1U << HOMEPAGE_FIELD,
+			LICENSE     = 1U << LICENSE_FIELD,
+			DIGEST      = 1U << DIGEST_FIELD,
+			VERSIONS    = (1U << VERSIONS_FIELD)|NAME,  /**< The package sets need the name */
+			ALL         = NAME|DESCRIPTION|HOMEPAGE|LICENSE|DIGEST|VERSIONS;
 
 		/** Initialize with file-stream and number of packages.
 		    @arg ps is used to define the local package sets while version reading */
 		PackageReader(Database *db, const DBHeader& hdr, PortageSettings *ps)
-			: m_db(db), m_frames(hdr.size), m_cat_size(0), m_pkg(NULLPTR), header(&hdr), m_portagesettings(ps), m_error(false) {
+			: m_db(db), m_frames(hdr.size), m_cat_size(0), m_cat_total(0), m_cat_offset(0), m_pkg(NULLPTR), header(&hdr), m_portagesettings(ps), m_selection(NULLPTR), m_error(false) {
 		}
 
 		PackageReader(Database *db, const DBHeader& hdr)
-			: m_db(db), m_frames(hdr.size), m_cat_size(0), m_pkg(NULLPTR), header(&hdr), m_portagesettings(NULLPTR), m_error(false) {
+			: m_db(db), m_frames(hdr.size), m_cat_size(0), m_cat_total(0), m_cat_offset(0), m_pkg(NULLPTR), header(&hdr), m_portagesettings(NULLPTR), m_selection(NULLPTR), m_error(false) {
 		}
 
 		~PackageReader();
 
-		/// Read attributes from the database into the current package.
+		/// Read the fields need from the database into the current package.
 		bool read(Attributes need);
 		bool read() {
 			return read(ALL);
@@ -70,13 +89,35 @@ class PackageReader {
 		// Read the package-header
 		bool next();
 
+		/// Let next() only visit the packages of sel (which must be in
+		/// database order). The category index must have been read.
+		void select(const IndexSelection *sel) {
+			m_selection = sel;
+			m_sel_pos = 0;
+		}
+
 		/// Go into the next (or first) category part.
 		// @return false if there are none more.
 		bool nextCategory();
 
+		/// Read the fields need of the next package in the current category.
+		// @return false if there are none more.
+		bool nextPackage(Attributes need);
+
 		/// Read the whole next package in the current category.
 		// @return false if there are none more.
-		bool nextPackage();
+		bool nextPackage() {
+			return nextPackage(ALL);
+		}
+
+		/// Go back to the first package of the current category.
+		bool restartCategory();
+
+		/// Return the digest of the current package (if DIGEST was read).
+		// It is empty if the database does not store digests.
+		const std::string& digest() const {
+			return m_digest;
+		}
 
 		/// Return name of current category.
 		const std::string& category() const {
@@ -91,16 +132,35 @@ class PackageReader {
 		Database         *m_db;
 
 		eix::Treesize     m_frames;
-		eix::Treesize     m_cat_size;
+		eix::Treesize     m_cat_size, m_cat_total;
+		eix::OffsetType   m_cat_offset;
 		std::string       m_cat_name;
+		std::string       m_digest;
 
 		off_t             m_next;
 		Attributes        m_have;
 		Package          *m_pkg;
 
+		/// The offsets of the fields of the current package in database
+		/// order; only the first m_known_offsets entries are known
+		eix::OffsetType   m_offsets[FIELD_COUNT];
+		FieldNum          m_known_offsets;
+
+		/// Move the file pointer to field i of the current package
+		bool seek_field(FieldNum i);
+
+		/// Read field i at the file pointer into the current package
+		bool read_field(FieldNum i);
+
+		/// Move the file pointer behind the current package
+		bool seek_next();
+
 		const DBHeader   *header;
 		PortageSettings  *m_portagesettings;
 
+		const IndexSelection *m_selection;
+		IndexSelection::size_type m_sel_pos;
+
 		std::string m_errtext;
 		bool m_error;
 };
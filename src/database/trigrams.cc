@@ -0,0 +1,178 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#include <config.h>
+
+#include <string>
+
+#include "database/trigrams.h"
+#include "eixTk/likely.h"
+
+using std::string;
+
+static string::size_type skip_bracket(const string& s, string::size_type i);
+
+void add_trigrams(TrigramSet *trigrams, const string& s) {
+	string::size_type len(s.size());
+	if(len < 3) {
+		return;
+	}
+	Trigram t(0);
+	// valid counts the last characters which are ASCII
+	string::size_type valid(0);
+	for(string::size_type i(0); likely(i != len); ++i) {
+		unsigned char c(s[i]);
+		if(unlikely(c >= 0x80)) {
+			valid = 0;
+			continue;
+		}
+		if((c >= 'A') && (c <= 'Z')) {
+			c = static_cast<unsigned char>(c - 'A' + 'a');
+		}
+		t = ((t << 8) | c) & 0xFFFFFFU;
+		if(++valid >= 3) {
+			trigrams->insert(t);
+		}
+	}
+}
+
+/** @return the index of the closing ']' of the bracket expression
+    starting at s[i], or string::npos */
+static string::size_type skip_bracket(const string& s, string::size_type i) {
+	string::size_type len(s.size());
+	++i;
+	if((i < len) && ((s[i] == '^') || (s[i] == '!'))) {
+		++i;
+	}
+	if((i < len) && (s[i] == ']')) {
+		++i;
+	}
+	for(; i < len; ++i) {
+		char c(s[i]);
+		if(c == ']') {
+			return i;
+		}
+		if((c == '[') && (i + 1 < len) &&
+			((s[i + 1] == ':') || (s[i + 1] == '.') || (s[i + 1] == '='))) {
+			// [:class:], [.coll.], [=equiv=]
+			char end[3] = { s[i + 1], ']', '\0' };
+			i = s.find(end, i + 2);
+			if(i == string::npos) {
+				return i;
+			}
+			++i;
+		}
+	}
+	return string::npos;
+}
+
+void add_regex_trigrams(TrigramSet *trigrams, const string& regex) {
+	// Alternatives are not analyzed
+	if(regex.find('|') != string::npos) {
+		return;
+	}
+	string literal;
+	string::size_type len(regex.size());
+	for(string::size_type i(0); i < len; ++i) {
+		char c(regex[i]);
+		switch(c) {
+			case '*':
+			case '?':
+			case '{':
+				// The previous character is optional
+				if(!literal.empty()) {
+					literal.erase(literal.size() - 1);
+				}
+				add_trigrams(trigrams, literal);
+				literal.clear();
+				if(c == '{') {
+					if((i = regex.find('}', i)) == string::npos) {
+						return;
+					}
+				}
+				break;
+			case '(': {
+					// The group might be optional: skip it
+					add_trigrams(trigrams, literal);
+					literal.clear();
+					unsigned int depth(1);
+					while(depth != 0) {
+						if(++i >= len) {
+							return;
+						}
+						c = regex[i];
+						if(c == '(') {
+							++depth;
+						} else if(c == ')') {
+							--depth;
+						} else if(c == '\\') {
+							++i;
+						} else if(c == '[') {
+							if((i = skip_bracket(regex, i)) == string::npos) {
+								return;
+							}
+						}
+					}
+				}
+				break;
+			case '[':
+				add_trigrams(trigrams, literal);
+				literal.clear();
+				if((i = skip_bracket(regex, i)) == string::npos) {
+					return;
+				}
+				break;
+			case '\\':
+				add_trigrams(trigrams, literal);
+				literal.clear();
+				++i;
+				break;
+			case '+':
+				// The previous character may be repeated
+			case '.':
+			case '^':
+			case '$':
+			case ')':
+				add_trigrams(trigrams, literal);
+				literal.clear();
+				break;
+			default:
+				literal.append(1, c);
+				break;
+		}
+	}
+	add_trigrams(trigrams, literal);
+}
+
+void add_pattern_trigrams(TrigramSet *trigrams, const string& pattern) {
+	string literal;
+	string::size_type len(pattern.size());
+	for(string::size_type i(0); i < len; ++i) {
+		char c(pattern[i]);
+		switch(c) {
+			case '[':
+				add_trigrams(trigrams, literal);
+				literal.clear();
+				if((i = skip_bracket(pattern, i)) == string::npos) {
+					return;
+				}
+				break;
+			case '\\':
+				++i;
+				// fallthrough
+			case '*':
+			case '?':
+				add_trigrams(trigrams, literal);
+				literal.clear();
+				break;
+			default:
+				literal.append(1, c);
+				break;
+		}
+	}
+	add_trigrams(trigrams, literal);
+}
@@ -0,0 +1,41 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#ifndef SRC_DATABASE_TRIGRAMS_H_
+#define SRC_DATABASE_TRIGRAMS_H_ 1
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "eixTk/eixint.h"
+
+/** Three consecutive bytes (lowercase ASCII) of a string packed into a number */
+typedef eix::UNumber Trigram;
+
+typedef std::set<Trigram> TrigramSet;
+
+/** The numbers (in database order) of the packages containing a trigram */
+typedef std::vector<eix::Treesize> TrigramPostings;
+
+typedef std::map<Trigram, TrigramPostings> TrigramIndex;
+
+/** Add the trigrams of s to *trigrams.
+    ASCII letters are converted to lowercase; trigrams containing other
+    characters than ASCII are ignored, since their case is not known. */
+void add_trigrams(TrigramSet *trigrams, const std::string& s) ATTRIBUTE_NONNULL_;
+
+/** Add the trigrams which every string matching the extended regular
+    expression regex must contain (case is ignored) */
+void add_regex_trigrams(TrigramSet *trigrams, const std::string& regex) ATTRIBUTE_NONNULL_;
+
+/** Add the trigrams which every string matching the fnmatch() pattern
+    must contain (case is ignored) */
+void add_pattern_trigrams(TrigramSet *trigrams, const std::string& pattern) ATTRIBUTE_NONNULL_;
+
+#endif  // SRC_DATABASE_TRIGRAMS_H_
@@ -0,0 +1,322 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#include <config.h>
+
+#include <dirent.h>
+
+#include <ctime>
+
+#include <string>
+#include <vector>
+
+#include "database/io.h"
+#include "database/vardb_index.h"
+#include "eixTk/constexpr.h"
+#include "eixTk/eixint.h"
+#include "eixTk/formated.h"
+#include "eixTk/i18n.h"
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+#include "eixTk/stringtypes.h"
+#include "eixTk/sysutils.h"
+#include "eixTk/utils.h"
+
+using std::string;
+using std::vector;
+
+/** The first string of the index and the version of its format */
+static const char vardb_index_magic[] = "eix-vardb";
+static CONSTEXPR eix::UNumber vardb_index_version = 1;
+
+const VarDbIndex::FileNum
+	VarDbIndex::SLOT_FILE,
+	VarDbIndex::IUSE_FILE,
+	VarDbIndex::USE_FILE,
+	VarDbIndex::REPOSITORY_FILE,
+	VarDbIndex::REPOSITORY_OLD_FILE,
+	VarDbIndex::RESTRICT_FILE,
+	VarDbIndex::BUILD_TIME_FILE,
+	VarDbIndex::DEPEND_FILE,
+	VarDbIndex::FILE_COUNT;
+
+const char *const VarDbIndex::filenames[VarDbIndex::FILE_COUNT] = {
+	"SLOT",
+	"IUSE",
+	"USE",
+	"repository",
+	"REPOSITORY",
+	"RESTRICT",
+	"BUILD_TIME",
+	"DEPEND",
+	"RDEPEND",
+	"PDEPEND",
+	"HDEPEND"
+};
+
+/** The data of an entry of a category directory as it is written */
+class VarDbEntry {
+	public:
+		string name;
+		eix::UNumber mtime;
+		bool exists[VarDbIndex::FILE_COUNT];
+		LineVec lines[VarDbIndex::FILE_COUNT];
+
+		/// Read the files of the directory dirname. Directories which are
+		/// modified not before now are marked as changed.
+		void read(const string& dirname, time_t now) {
+			time_t t(get_mtime(dirname.c_str()));
+			mtime = ((t < now) ? static_cast<eix::UNumber>(t) : 0);
+			for(VarDbIndex::FileNum i(0); likely(i != VarDbIndex::FILE_COUNT); ++i) {
+				exists[i] = pushback_lines((dirname + "/" + VarDbIndex::filenames[i]).c_str(),
+					&(lines[i]), false, false, 1);
+				if(!exists[i]) {
+					lines[i].clear();
+				}
+			}
+		}
+};
+
+bool VarDbIndex::open(const char *file, const string& directory) {
+	if(!openread(file)) {
+		return false;
+	}
+	string errtext, str;
+	eix::UNumber num, count;
+	if(unlikely(!read_string(&str, &errtext)) ||
+		unlikely(str != vardb_index_magic) ||
+		unlikely(!read_num(&num, &errtext)) ||
+		unlikely(num != vardb_index_version) ||
+		unlikely(!read_string(&str, &errtext)) ||
+		(str != directory) ||
+		unlikely(!read_num(&num, &errtext)) ||
+		unlikely(!read_num(&count, &errtext))) {
+		return false;
+	}
+	m_directory = directory;
+	m_know_all = ((num != 0) &&
+		(num == static_cast<eix::UNumber>(get_mtime(directory.c_str()))));
+	for(; likely(count != 0); --count) {
+		eix::OffsetType len;
+		if(unlikely(!read_string(&str, &errtext))) {
+			break;
+		}
+		CategoryData& cat(m_categories[str]);
+		if(unlikely(!read_num(&(cat.mtime), &errtext)) ||
+			unlikely(!read_num(&len, &errtext))) {
+			break;
+		}
+		cat.offset = tell();
+		if(unlikely(!seekrel(len, &errtext))) {
+			break;
+		}
+	}
+	if(likely(count == 0)) {
+		return true;
+	}
+	m_categories.clear();
+	return false;
+}
+
+eix::SignedBool VarDbIndex::read_category(const string& category, Entries *entries) {
+	Categories::const_iterator it(m_categories.find(category));
+	if(it == m_categories.end()) {
+		return (m_know_all ? 0 : -1);
+	}
+	const CategoryData& cat(it->second);
+	if((cat.mtime == 0) ||
+		(cat.mtime != static_cast<eix::UNumber>(get_mtime((m_directory + category).c_str())))) {
+		return -1;
+	}
+	string errtext;
+	eix::UNumber count;
+	if(unlikely(!seekabs(cat.offset, &errtext)) ||
+		unlikely(!read_num(&count, &errtext))) {
+		return -1;
+	}
+	for(; likely(count != 0); --count) {
+		string name;
+		eix::OffsetType len;
+		if(unlikely(!read_string(&name, &errtext)) ||
+			unlikely(!read_num(&len, &errtext))) {
+			break;
+		}
+		entries->push_back(std::make_pair(name, tell()));
+		if(unlikely(!seekrel(len, &errtext))) {
+			break;
+		}
+	}
+	if(likely(count == 0)) {
+		return 1;
+	}
+	entries->clear();
+	return -1;
+}
+
+bool VarDbIndex::unchanged(eix::OffsetType offset, const string& dirname) {
+	string errtext;
+	eix::UNumber mtime;
+	return (likely(seekabs(offset, &errtext)) &&
+		likely(read_num(&mtime, &errtext)) &&
+		(mtime != 0) &&
+		(mtime == static_cast<eix::UNumber>(get_mtime(dirname.c_str()))));
+}
+
+eix::SignedBool VarDbIndex::read_lines(eix::OffsetType offset, FileNum num, LineVec *lines) {
+	string errtext;
+	eix::UNumber n;
+	// Skip the mtime
+	if(unlikely(!seekabs(offset, &errtext)) ||
+		unlikely(!read_num(&n, &errtext))) {
+		return -1;
+	}
+	for(FileNum i(0); ; ++i) {
+		if(unlikely(!read_num(&n, &errtext))) {
+			return -1;
+		}
+		if(i == num) {
+			break;
+		}
+		for(; n > 1; --n) {
+			if(unlikely(!skip_string(&errtext))) {
+				return -1;
+			}
+		}
+	}
+	if(n == 0) {
+		return 0;
+	}
+	for(; n > 1; --n) {
+		string line;
+		if(unlikely(!read_string(&line, &errtext))) {
+			lines->clear();
+			return -1;
+		}
+		lines->push_back(line);
+	}
+	return 1;
+}
+
+bool VarDbIndex::write_index(const char *file, const string& directory, string *errtext) {
+	time_t now(time(NULLPTR));
+	VarDbIndex index;
+	if(unlikely(!index.openwrite(file))) {
+		if(errtext != NULLPTR) {
+			*errtext = eix::format(_("cannot open %r for writing (mode = 'wb')")) % file;
+		}
+		return false;
+	}
+	index.m_directory = directory;
+	time_t mtime(get_mtime(directory.c_str()));
+	WordVec categories;
+	DIR *dir(opendir(directory.c_str()));
+	if(dir != NULLPTR) {
+		struct dirent *entry;
+		while(likely((entry = readdir(dir)) != NULLPTR)) {  // NOLINT(runtime/threadsafe_fn)
+			if(entry->d_name[0] != '.') {
+				categories.push_back(entry->d_name);
+			}
+		}
+		closedir(dir);
+	}
+	if(unlikely(!index.write_string(vardb_index_magic, errtext)) ||
+		unlikely(!index.write_num(vardb_index_version, errtext)) ||
+		unlikely(!index.write_string(directory, errtext)) ||
+		unlikely(!index.write_num(((dir != NULLPTR) && (mtime < now)) ?
+			static_cast<eix::UNumber>(mtime) : 0, errtext)) ||
+		unlikely(!index.write_num(categories.size(), errtext))) {
+		return false;
+	}
+	for(WordVec::const_iterator it(categories.begin());
+		likely(it != categories.end()); ++it) {
+		if(unlikely(!index.write_category(*it, now, errtext))) {
+			return false;
+		}
+	}
+	return index.commit(errtext);
+}
+
+bool VarDbIndex::write_category(const string& category, time_t now, string *errtext) {
+	string dirname(m_directory + category);
+	time_t mtime(get_mtime(dirname.c_str()));
+	vector<VarDbEntry> entries;
+	DIR *dir(opendir(dirname.c_str()));
+	if(dir != NULLPTR) {
+		dirname.append(1, '/');
+		struct dirent *entry;
+		while(likely((entry = readdir(dir)) != NULLPTR)) {  // NOLINT(runtime/threadsafe_fn)
+			if(entry->d_name[0] == '.') {
+				continue;
+			}
+			entries.push_back(VarDbEntry());
+			VarDbEntry& curr(entries.back());
+			curr.name = entry->d_name;
+			curr.read(dirname + curr.name, now);
+		}
+		closedir(dir);
+	}
+	if(unlikely(!write_string(category, errtext)) ||
+		unlikely(!write_num(((dir != NULLPTR) && (mtime < now)) ?
+			static_cast<eix::UNumber>(mtime) : 0, errtext))) {
+		return false;
+	}
+	// Write the length in front of the entries to be able to skip them
+	counting = true;
+	counter = 0;
+	write_entries(entries, NULLPTR);
+	counting = false;
+	return (likely(write_num(counter, errtext)) &&
+		likely(write_entries(entries, errtext)));
+}
+
+bool VarDbIndex::write_entries(const vector<VarDbEntry>& entries, string *errtext) {
+	if(unlikely(!write_num(entries.size(), errtext))) {
+		return false;
+	}
+	for(vector<VarDbEntry>::const_iterator it(entries.begin());
+		likely(it != entries.end()); ++it) {
+		if(unlikely(!write_entry(*it, errtext))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool VarDbIndex::write_entry(const VarDbEntry& entry, string *errtext) {
+	if(unlikely(!write_string(entry.name, errtext))) {
+		return false;
+	}
+	bool counting_save(counting);
+	eix::OffsetType counter_save(counter);
+	counting = true;
+	counter = 0;
+	write_entry_data(entry, NULLPTR);
+	eix::OffsetType len(counter);
+	counting = counting_save;
+	counter = counter_save;
+	return (likely(write_num(len, errtext)) &&
+		likely(write_entry_data(entry, errtext)));
+}
+
+bool VarDbIndex::write_entry_data(const VarDbEntry& entry, string *errtext) {
+	if(unlikely(!write_num(entry.mtime, errtext))) {
+		return false;
+	}
+	for(FileNum i(0); likely(i != FILE_COUNT); ++i) {
+		const LineVec& lines(entry.lines[i]);
+		if(unlikely(!write_num(entry.exists[i] ? (lines.size() + 1) : 0, errtext))) {
+			return false;
+		}
+		for(LineVec::const_iterator it(lines.begin());
+			likely(it != lines.end()); ++it) {
+			if(unlikely(!write_string(*it, errtext))) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
@@ -0,0 +1,98 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#ifndef SRC_DATABASE_VARDB_INDEX_H_
+#define SRC_DATABASE_VARDB_INDEX_H_ 1
+
+#include <ctime>
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "database/io.h"
+#include "eixTk/constexpr.h"
+#include "eixTk/eixint.h"
+#include "eixTk/stringtypes.h"
+
+/** The directory of the installed packages (after EPREFIX_INSTALLED) */
+#define VAR_DB_PKG "/var/db/pkg/"
+
+class VarDbEntry;
+
+/** A persistent index of the installed packages in /var/db/pkg:
+    It contains the entries of all category directories and the content of
+    those files of the installed versions which VarDbPkg reads.
+    The index is written by eix-update. A category is only taken from the
+    index if the mtime of its directory has not changed since then, and
+    the files of a version only if the mtime of its directory has not. */
+class VarDbIndex : public Database {
+	public:
+		/// The files of an installed version which are stored
+		typedef eix::TinyUnsigned FileNum;
+		static CONSTEXPR FileNum
+			SLOT_FILE            = 0,
+			IUSE_FILE            = 1,
+			USE_FILE             = 2,
+			REPOSITORY_FILE      = 3,
+			REPOSITORY_OLD_FILE  = 4,
+			RESTRICT_FILE        = 5,
+			BUILD_TIME_FILE      = 6,
+			DEPEND_FILE          = 7,  /**< followed by RDEPEND, PDEPEND, HDEPEND */
+			FILE_COUNT           = 11;
+		static const char *const filenames[FILE_COUNT];
+
+		/// The names of the entries of a category directory and the offsets
+		/// of their data in the index
+		typedef std::vector<std::pair<std::string, eix::OffsetType> > Entries;
+
+		VarDbIndex() : m_know_all(false) {
+		}
+
+		/// Open the index file for the installed packages in directory.
+		/// @return false if it cannot be read or belongs to another directory
+		bool open(const char *file, const std::string& directory) ATTRIBUTE_NONNULL_;
+
+		/// Get the entries of the directory of category.
+		/// @return 1 if they are in the index, 0 if the category is known
+		/// not to exist, and -1 if the category must be read from disk.
+		eix::SignedBool read_category(const std::string& category, Entries *entries) ATTRIBUTE_NONNULL_;
+
+		/// Test whether the directory of the entry at offset is unchanged.
+		bool unchanged(eix::OffsetType offset, const std::string& dirname);
+
+		/// Read the lines of file num of the entry at offset.
+		/// @return 1 if the file exists, 0 if not, -1 on read errors
+		eix::SignedBool read_lines(eix::OffsetType offset, FileNum num, LineVec *lines) ATTRIBUTE_NONNULL_;
+
+		/// Write an index of the installed packages in directory to file.
+		/// The file is replaced only when the index is complete, since
+		/// other processes may read the old one.
+		static bool write_index(const char *file, const std::string& directory, std::string *errtext) ATTRIBUTE_NONNULL((1));
+
+	private:
+		class CategoryData {
+			public:
+				eix::UNumber mtime;
+				eix::OffsetType offset;
+		};
+		typedef std::map<std::string, CategoryData> Categories;
+
+		std::string m_directory;
+		Categories m_categories;
+
+		/// True if all existing categories are in the index
+		bool m_know_all;
+
+		bool write_category(const std::string& category, time_t now, std::string *errtext);
+		bool write_entries(const std::vector<VarDbEntry>& entries, std::string *errtext);
+		bool write_entry(const VarDbEntry& entry, std::string *errtext);
+		bool write_entry_data(const VarDbEntry& entry, std::string *errtext);
+};
+
+#endif  // SRC_DATABASE_VARDB_INDEX_H_
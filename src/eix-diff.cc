@@ -23,6 +23,8 @@
 
 #include "database/header.h"
 #include "database/io.h"
+#include "database/package_reader.h"
+#include "database/vardb_index.h"
 #include "eixTk/ansicolor.h"
 #include "eixTk/argsreader.h"
 #include "eixTk/filenames.h"
@@ -30,6 +32,9 @@
 #include "eixTk/i18n.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
+#include "eixTk/outputsink.h"
+#include "eixTk/ptr_list.h"
+#include "eixTk/stringtypes.h"
 #include "eixTk/utils.h"
 #include "eixrc/eixrc.h"
 #include "eixrc/global.h"
@@ -39,14 +44,13 @@
 #include "portage/conf/portagesettings.h"
 #include "portage/depend.h"
 #include "portage/extendedversion.h"
+#include "portage/overlay.h"
 #include "portage/package.h"
 #include "portage/packagetree.h"
 #include "portage/set_stability.h"
 #include "portage/vardbpkg.h"
 #include "various/drop_permissions.h"
 
-#define VAR_DB_PKG "/var/db/pkg/"
-
 using std::string;
 
 using std::cerr;
@@ -54,8 +58,9 @@ using std::cout;
 using std::endl;
 
 static void print_help();
-static void load_db(const char *file, DBHeader *header, PackageTree *body, PortageSettings *ps) ATTRIBUTE_NONNULL_;
+static void db_error(const char *file, const string& errtext) ATTRIBUTE_NONNULL_ ATTRIBUTE_NORETURN;
 static void set_virtual(PrintFormat *fmt, const DBHeader& header, const string& eprefix_virtual) ATTRIBUTE_NONNULL_;
+static bool comparable_digests(const DBHeader& old_hdr, const DBHeader& new_hdr, const string& profile_fingerprint) ATTRIBUTE_PURE;
 static void print_changed_package(Package *op, Package *np) ATTRIBUTE_NONNULL_;
 static void print_found_package(Package *p) ATTRIBUTE_NONNULL_;
 static void print_lost_package(Package *p) ATTRIBUTE_NONNULL_;
@@ -137,23 +142,146 @@ EixDiffOptionList::EixDiffOptionList() {
 	push_back(Option("ansi",         O_ANSI, Option::BOOLEAN_T, &cli_ansi));
 }
 
-static void load_db(const char *file, DBHeader *header, PackageTree *body, PortageSettings *ps) {
-	Database db;
-	if(likely(db.openread(file))) {
-		string errtext;
-		if(likely(db.read_header(header, &errtext))) {
+static void db_error(const char *file, const string& errtext) {
+	cerr << eix::format(_("error in database file %r: %s")) % file % errtext << endl;
+	exit(EXIT_FAILURE);
+}
+
+/** A database which is read category by category */
+class DiffReader {
+	public:
+		DiffReader(const char *file, DBHeader *header, PortageSettings *ps) ATTRIBUTE_NONNULL_ :
+			m_file(file), m_header(header), m_reader(NULLPTR), m_stability(NULLPTR) {
+			if(unlikely(!m_db.openread(file))) {
+				cerr << eix::format(_("cannot open database file %r for reading (mode = 'rb')")) % file << endl;
+				exit(EXIT_FAILURE);
+			}
+			string errtext;
+			if(unlikely(!m_db.read_header(header, &errtext))) {
+				db_error(file, errtext);
+			}
 			header->set_priorities(ps);
 			ps->store_world_sets(&(header->world_sets));
-			if(likely(db.read_packagetree(body, *header, ps, &errtext))) {
-				return;
+			m_reader = new PackageReader(&m_db, *header, ps);
+		}
+
+		~DiffReader() {
+			delete m_reader;
+		}
+
+		void set_stability(const SetStability *stability) ATTRIBUTE_NONNULL_ {
+			m_stability = stability;
+		}
+
+		/// Count the packages without reading them.
+		/// Must be called before reading the first category.
+		eix::Treesize count_packages() {
+			PackageReader counter(&m_db, *m_header);
+			eix::Treesize count(0);
+			while(likely(counter.next()) && likely(counter.skip())) {
+				++count;
+			}
+			string errtext;
+			const char *c(counter.get_errtext());
+			if(unlikely(c != NULLPTR)) {
+				db_error(m_file, c);
+			}
+			if(unlikely(!m_db.seekabs(m_header->tree_offset, &errtext))) {
+				db_error(m_file, errtext);
 			}
+			return count;
 		}
-		cerr << eix::format(_("error in database file %r: %s")) % file % errtext << endl;
-	} else {
-		cerr << eix::format(_("cannot open database file %r for reading (mode = 'rb')")) % file << endl;
-	}
-	exit(EXIT_FAILURE);
-}
+
+		/// Go to the next category of the database.
+		/// @return false if there are none more
+		bool next_category() {
+			if(m_reader->nextCategory()) {
+				return true;
+			}
+			check_error();
+			return false;
+		}
+
+		/// Append the packages of the current category to *cat,
+		/// omitting those with a name in *omit (if not NULLPTR).
+		void read_category(Category *cat, const WordSet *omit) ATTRIBUTE_NONNULL((2)) {
+			PackageReader::Attributes need((omit == NULLPTR) ?
+				PackageReader::ALL : PackageReader::NAME);
+			while(m_reader->nextPackage(need)) {
+				if((omit != NULLPTR) &&
+					(omit->find(m_reader->get()->name) != omit->end())) {
+					skip_package();
+					continue;
+				}
+				push_package(cat);
+			}
+			check_error();
+		}
+
+		/// Store the digests of the packages of the current category
+		/// and go back to its beginning.
+		void read_digests(WordMap *digests) ATTRIBUTE_NONNULL_ {
+			while(m_reader->nextPackage(PackageReader::NAME|PackageReader::DIGEST)) {
+				(*digests)[m_reader->get()->name] = m_reader->digest();
+				skip_package();
+			}
+			check_error();
+			m_reader->restartCategory();
+			check_error();
+		}
+
+		/// Append the packages of the current category to *cat whose
+		/// digest differs from that in digests; the names of the others
+		/// are stored in *unchanged, and their versions are not read.
+		void read_changed(Category *cat, const WordMap& digests, WordSet *unchanged) ATTRIBUTE_NONNULL((2, 4)) {
+			while(m_reader->nextPackage(PackageReader::NAME|PackageReader::DIGEST)) {
+				const string& name(m_reader->get()->name);
+				const string& digest(m_reader->digest());
+				WordMap::const_iterator it(digests.find(name));
+				if(likely(!digest.empty()) && (it != digests.end()) &&
+					(it->second == digest)) {
+					unchanged->insert(name);
+					skip_package();
+					continue;
+				}
+				push_package(cat);
+			}
+			check_error();
+		}
+
+		const string& category() const {
+			return m_reader->category();
+		}
+
+	private:
+		Database m_db;
+		const char *m_file;
+		const DBHeader *m_header;
+		PackageReader *m_reader;
+		const SetStability *m_stability;
+
+		void check_error() const {
+			const char *c(m_reader->get_errtext());
+			if(unlikely(c != NULLPTR)) {
+				db_error(m_file, c);
+			}
+		}
+
+		void skip_package() {
+			if(unlikely(!m_reader->skip())) {
+				check_error();
+			}
+		}
+
+		void push_package(Category *cat) ATTRIBUTE_NONNULL_ {
+			Package *p(m_reader->release());
+			if(unlikely(p == NULLPTR)) {
+				check_error();
+			}
+			m_stability->set_stability(p);
+			cat->push_back(p);
+		}
+};
 
 static void set_virtual(PrintFormat *fmt, const DBHeader& header, const string& eprefix_virtual) {
 	if(header.countOverlays() == 0) {
@@ -164,6 +292,30 @@ static void set_virtual(PrintFormat *fmt, const DBHeader& header, const string&
 		fmt->set_as_virtual(i, is_virtual((eprefix_virtual + header.getOverlay(i).path).c_str()));
 }
 
+/** Packages with equal digests in both databases have the same versions,
+    keywords, stored masks, and overlay numbers. These are only comparable
+    if the databases store digests and have the same overlays and world sets.
+    Since the masks of the new database are recalculated, the profile must
+    also be the same as when eix-update wrote it. */
+static bool comparable_digests(const DBHeader& old_hdr, const DBHeader& new_hdr, const string& profile_fingerprint) {
+	if((old_hdr.version < 38) || (new_hdr.version < 39) ||
+		(old_hdr.countOverlays() != new_hdr.countOverlays()) ||
+		(old_hdr.world_sets != new_hdr.world_sets) ||
+		(new_hdr.profile_fingerprint != profile_fingerprint)) {
+		return false;
+	}
+	for(ExtendedVersion::Overlay i(0); likely(i != old_hdr.countOverlays()); ++i) {
+		const OverlayIdent& old_overlay(old_hdr.getOverlay(i));
+		const OverlayIdent& new_overlay(new_hdr.getOverlay(i));
+		if((old_overlay.path != new_overlay.path) ||
+			(old_overlay.label != new_overlay.label) ||
+			(old_overlay.priority != new_overlay.priority)) {
+			return false;
+		}
+	}
+	return true;
+}
+
 class DiffTrees {
 	public:
 		typedef void (*lost_func) (Package *p) ATTRIBUTE_NONNULL_;
@@ -179,27 +331,57 @@ class DiffTrees {
 			m_slots(compare_slots), m_separate_deleted(separate_deleted) {
 		}
 
-		/// Diff the trees and run callbacks
-		void diff(PackageTree *old_tree, PackageTree *new_tree) ATTRIBUTE_NONNULL_ {
-			// Diff every category from the old tree with the category from the new tree
-			for(PackageTree::iterator old_cat(old_tree->begin());
-				likely(old_cat != old_tree->end()); ++old_cat) {
-				diff_category(old_cat->second, &(*new_tree)[old_cat->first]);
+		/// Diff the databases and run callbacks.
+		/// Both are read simultaneously category by category (which are
+		/// sorted); only new packages and (if m_separate_deleted) lost
+		/// packages are kept until the end to preserve the output order.
+		/// If use_digests, packages with equal digests are not read.
+		void diff(DiffReader *old_db, DiffReader *new_db, bool use_digests) ATTRIBUTE_NONNULL_ {
+			Category old_cat, new_cat;
+			eix::ptr_list<Package> lost, found;
+			bool have_new(new_db->next_category());
+			while(likely(old_db->next_category())) {
+				const string& name(old_db->category());
+				// Categories which are only in the new tree
+				while(have_new && (new_db->category() < name)) {
+					new_db->read_category(&new_cat, NULLPTR);
+					new_cat.splice_to(&found);
+					have_new = new_db->next_category();
+				}
+				if(have_new && (new_db->category() == name)) {
+					if(use_digests) {
+						WordMap digests;
+						WordSet unchanged;
+						new_db->read_digests(&digests);
+						old_db->read_changed(&old_cat, digests, &unchanged);
+						new_db->read_category(&new_cat, &unchanged);
+					} else {
+						old_db->read_category(&old_cat, NULLPTR);
+						new_db->read_category(&new_cat, NULLPTR);
+					}
+					diff_category(&old_cat, &new_cat);
+					new_cat.splice_to(&found);
+					have_new = new_db->next_category();
+				} else {
+					old_db->read_category(&old_cat, NULLPTR);
+					Category empty;
+					diff_category(&old_cat, &empty);
+				}
+				// Now we've only lost packages in old_cat
+				old_cat.splice_to(&lost);
+			}
+			while(have_new) {
+				new_db->read_category(&new_cat, NULLPTR);
+				new_cat.splice_to(&found);
+				have_new = new_db->next_category();
 			}
-
-			// Now we've only new package in the new_tree
-			// and lost packages in the old_tree
 
 			if(m_separate_deleted) {
-				for(PackageTree::iterator old_cat(old_tree->begin());
-					likely(old_cat != old_tree->end()); ++old_cat) {
-					for_each(old_cat->second->begin(), old_cat->second->end(), lost_package);
-				}
-			}
-			for(PackageTree::iterator new_cat(new_tree->begin());
-				likely(new_cat != new_tree->end()); ++new_cat) {
-				for_each(new_cat->second->begin(), new_cat->second->end(), found_package);
+				for_each(lost.begin(), lost.end(), lost_package);
 			}
+			for_each(found.begin(), found.end(), found_package);
+			lost.delete_and_clear();
+			found.delete_and_clear();
 		}
 
 	private:
@@ -342,6 +524,9 @@ int run_eix_diff(int argc, char *argv[]) {
 		}
 	}
 
+	// From now on, stdout is only written through std::cout
+	OutputSink::redirect_cout();
+
 	bool have_new(false);
 	if(unlikely((current_param != argreader.end()) && (current_param->type == Parameter::ARGUMENT))) {
 		old_file = current_param->m_argument;
@@ -373,6 +558,7 @@ int run_eix_diff(int argc, char *argv[]) {
 		rc.getBool("RESTRICT_INSTALLED"), rc.getBool("CARE_RESTRICT_INSTALLED"),
 		rc.getBool("USE_BUILD_TIME"));
 	varpkg_db->check_installed_overlays = rc.getBoolText("CHECK_INSTALLED_OVERLAYS", "repository");
+	varpkg_db->useIndex(rc["VARDB_INDEX"]);
 
 	bool local_settings(rc.getBool("LOCAL_PORTAGE_CONFIG"));
 	bool always_accept_keywords(rc.getBool("ALWAYS_ACCEPT_KEYWORDS"));
@@ -380,15 +566,13 @@ int run_eix_diff(int argc, char *argv[]) {
 	set_stability_new = new SetStability(portagesettings, local_settings, false, always_accept_keywords);
 	format_for_new->recommend_mode = rc.getLocalMode("RECOMMEND_LOCAL_MODE");
 
-	PackageTree new_tree;
 	new_header = new DBHeader;
-	load_db(new_file.c_str(), new_header, &new_tree, portagesettings);
-	set_stability_new->set_stability(&new_tree);
+	DiffReader new_db(new_file.c_str(), new_header, portagesettings);
+	new_db.set_stability(set_stability_new);
 
-	PackageTree old_tree;
 	old_header = new DBHeader;
-	load_db(old_file.c_str(), old_header, &old_tree, portagesettings);
-	set_stability_old->set_stability(&old_tree);
+	DiffReader old_db(old_file.c_str(), old_header, portagesettings);
+	old_db.set_stability(set_stability_old);
 
 	format_for_new->set_overlay_translations(NULLPTR);
 
@@ -398,25 +582,30 @@ int run_eix_diff(int argc, char *argv[]) {
 	set_virtual(format_for_old, *old_header, eprefix_virtual);
 	set_virtual(format_for_new, *new_header, eprefix_virtual);
 
+	bool only_installed(rc.getBool("DIFF_ONLY_INSTALLED"));
 	DiffTrees differ(varpkg_db, portagesettings,
-		rc.getBool("DIFF_ONLY_INSTALLED"),
+		only_installed,
 		!rc.getBool("DIFF_NO_SLOTS"),
 		rc.getBool("DIFF_SEPARATE_DELETED"));
 
 	if(likely(rc.getBool("DIFF_PRINT_HEADER"))) {
+		eix::Treesize new_count(new_db.count_packages());
 		cout << eix::format(N_(
 			"Diffing databases (%s -> %s package)\n",
 			"Diffing databases (%s -> %s packages)\n",
-			new_tree.countPackages()))
-			% old_tree.countPackages()
-			% new_tree.countPackages();
+			new_count))
+			% old_db.count_packages()
+			% new_count;
 	}
 
 	differ.lost_package    = print_lost_package;
 	differ.found_package   = print_found_package;
 	differ.changed_package = print_changed_package;
 
-	differ.diff(&old_tree, &new_tree);
+	// With DIFF_ONLY_INSTALLED, even unchanged packages are reported
+	differ.diff(&old_db, &new_db,
+		!only_installed && comparable_digests(*old_header, *new_header,
+			portagesettings->profile_fingerprint()));
 	cout << format_for_new->color_end;
 
 	delete varpkg_db;
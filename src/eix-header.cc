@@ -227,7 +227,7 @@ int overlay_loop(string *result, const OverlayOptionList& options) {
 
 bool open_database(DBHeader *header, const char *name, bool verbose) {
 	Database db;
-	if(likely((name[0] != '\0') && db.openread(name))) {
+	if(likely((name[0] != '\0') && db.openread(name, false))) {
 		if(likely(db.read_header(header, NULLPTR))) {
 			return true;
 		}
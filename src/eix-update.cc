@@ -13,6 +13,7 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cstdlib>
 
 #include <iostream>
@@ -23,6 +24,8 @@
 #include "cache/cachetable.h"
 #include "database/header.h"
 #include "database/io.h"
+#include "database/package_reader.h"
+#include "database/vardb_index.h"
 #include "eixTk/argsreader.h"
 #include "eixTk/filenames.h"
 #include "eixTk/formated.h"
@@ -34,6 +37,7 @@
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
 #include "eixTk/sysutils.h"
+#include "eixTk/threads.h"
 #include "eixTk/utils.h"
 #include "eixrc/eixrc.h"
 #include "eixrc/global.h"
@@ -42,7 +46,9 @@
 #include "portage/depend.h"
 #include "portage/extendedversion.h"
 #include "portage/overlay.h"
+#include "portage/package.h"
 #include "portage/packagetree.h"
+#include "portage/version.h"
 #include "various/drop_permissions.h"
 
 using std::list;
@@ -108,6 +114,16 @@ typedef vector<RepoName> RepoNames;
 static void print_help();
 static bool update(const char *outputfile, CacheTable *cache_table, PortageSettings *portage_settings, bool override_umask, const RepoNames& repo_names, const WordVec& exclude_labels, Statusline *statusline, string *errtext) ATTRIBUTE_NONNULL_;
 static void error_callback(const string& str);
+static void print_cache_info(const BasicCache *cache, Statusline *statusline) ATTRIBUTE_NONNULL_;
+static void read_parallel(CacheTable::iterator begin, CacheTable::iterator end, const PackageTree& package_tree);
+static void read_parallel_worker(void *data) ATTRIBUTE_NONNULL_;
+static void mask_parallel(const PackageTree& package_tree, PortageSettings *portage_settings) ATTRIBUTE_NONNULL_;
+static void mask_parallel_worker(void *data) ATTRIBUTE_NONNULL_;
+static void hash_parallel(DBHeader *dbheader, const PackageTree& package_tree) ATTRIBUTE_NONNULL_;
+static void hash_parallel_worker(void *data) ATTRIBUTE_NONNULL_;
+static void calc_fingerprints(DBHeader *dbheader, CacheTable *cache_table, const PackageTree& package_tree, const PortageSettings& portage_settings) ATTRIBUTE_NONNULL_;
+static void reuse_categories(const char *outputfile, const DBHeader& dbheader, PackageTree *package_tree, WordVec *reused) ATTRIBUTE_NONNULL_;
+static void move_categories(PackageTree *from, PackageTree *to, const WordVec& names) ATTRIBUTE_NONNULL_;
 static void add_pathnames(PathVec *add_list, const WordVec& to_add, bool must_resolve) ATTRIBUTE_NONNULL_;
 static void add_override(Overrides *override_list, EixRc *eixrc, const char *s) ATTRIBUTE_NONNULL_;
 static void add_reponames(RepoNames *repo_names, EixRc *eixrc, const char *s) ATTRIBUTE_NONNULL_;
@@ -129,6 +145,9 @@ static void print_help() {
 "     --force-status      always output status line\n"
 " -F, --force-color       force \"color\" even if output is no terminal\n"
 " -v, --verbose           output used cache method for each ebuild\n"
+" -j, --jobs N            use N parallel threads (0: #cpus)\n"
+" -i, --incremental       reuse unchanged categories from the previous database\n"
+"     --no-incremental    read all categories from the caches\n"
 "\n"
 " -q, --quiet             produce no output\n"
 "\n"
@@ -153,7 +172,8 @@ enum cli_options {
 	O_DUMP_DEFAULTS,
 	O_KNOWN_VARS,
 	O_PRINT_VAR,
-	O_FORCE_STATUS
+	O_FORCE_STATUS,
+	O_NO_INCREMENTAL
 };
 
 static bool
@@ -164,7 +184,9 @@ static bool
 	dump_eixrc(false),
 	dump_defaults(false);
 
-static bool use_percentage, use_status, verbose;
+static bool use_percentage, use_status, verbose, category_index, trigram_index, incremental;
+
+static unsigned int jobs;
 
 typedef list<const char *> ExcludeArgs;
 typedef ExcludeArgs AddArgs;
@@ -178,6 +200,7 @@ static RepoArgs *repo_args;
 
 static const char *outputname = NULLPTR;
 static const char *var_to_print = NULLPTR;
+static const char *jobs_arg = NULLPTR;
 
 /** Arguments and options. */
 class EixUpdateOptionList : public OptionList {
@@ -198,6 +221,9 @@ EixUpdateOptionList::EixUpdateOptionList() {
 	push_back(Option("force-color",    'F',     Option::BOOLEAN_T,  &use_percentage));
 	push_back(Option("force-status", O_FORCE_STATUS, Option::BOOLEAN_T, &use_status));
 	push_back(Option("verbose",        'v',     Option::BOOLEAN_T,  &verbose));
+	push_back(Option("jobs",           'j',     Option::STRING,     &jobs_arg));
+	push_back(Option("incremental",    'i',     Option::BOOLEAN_T,  &incremental));
+	push_back(Option("no-incremental", O_NO_INCREMENTAL, Option::BOOLEAN_F, &incremental));
 
 	push_back(Option("exclude-overlay", 'x',    Option::STRINGLIST, exclude_args));
 	push_back(Option("add-overlay",    'a',     Option::STRINGLIST, add_args));
@@ -208,6 +234,9 @@ EixUpdateOptionList::EixUpdateOptionList() {
 
 static PercentStatus *reading_percent_status;
 
+/// Protects reading_percent_status and cerr while reading in parallel
+static eix::Mutex output_mutex;
+
 
 static void add_pathnames(PathVec *add_list, const WordVec& to_add, bool must_resolve) {
 	for(WordVec::const_iterator it(to_add.begin());
@@ -245,7 +274,7 @@ static void add_reponames(RepoNames *repo_names, EixRc *eixrc, const char *s) {
 
 static void add_virtuals(Overrides *override_list, PathVec *add, RepoNames *repo_names, const string& cachefile, const string& eprefix_virtual) {
 	Database db;
-	if(unlikely(!db.openread(cachefile.c_str()))) {
+	if(unlikely(!db.openread(cachefile.c_str(), false))) {
 		INFO(eix::format(_(
 			"KEEP_VIRTUALS is ignored: there is no previous %s\n"))
 			% cachefile);
@@ -344,6 +373,9 @@ int run_eix_update(int argc, char *argv[]) {
 
 	/* other defaults */
 	verbose = eixrc.getBool("UPDATE_VERBOSE");
+	category_index = eixrc.getBool("UPDATE_CATEGORY_INDEX");
+	trigram_index = eixrc.getBool("UPDATE_TRIGRAM_INDEX");
+	incremental = eixrc.getBool("UPDATE_INCREMENTAL");
 
 	/* Setup ArgumentReader. */
 	ArgumentReader argreader(argc, argv, EixUpdateOptionList());
@@ -372,6 +404,17 @@ int run_eix_update(int argc, char *argv[]) {
 		dump_version();
 	}
 
+#ifdef WITH_THREADS
+	jobs = ((jobs_arg != NULLPTR) ?
+		static_cast<unsigned int>(my_atoi(jobs_arg)) :
+		eixrc.getInteger("UPDATE_JOBS"));
+	if(jobs == 0) {
+		jobs = eix::available_processors();
+	}
+#else
+	jobs = 1;
+#endif
+
 	if(unlikely(dump_eixrc || dump_defaults)) {
 		eixrc.dumpDefaults(stdout, dump_defaults);
 		return EXIT_SUCCESS;
@@ -547,16 +590,374 @@ int run_eix_update(int argc, char *argv[]) {
 		statusline.failure();
 		return EXIT_FAILURE;
 	}
+
+	/* Failing to write the index of installed packages is not fatal */
+	string vardb_index(eixrc["VARDB_INDEX"]);
+	if(eixrc.getBool("UPDATE_VARDB_INDEX") && !vardb_index.empty()) {
+		INFO(eix::format(_("Writing index of installed packages %s ..\n")) % vardb_index);
+		mode_t old_umask(0);
+		if(override_umask) {
+			old_umask = umask(2);
+		}
+		if(unlikely(!VarDbIndex::write_index(vardb_index.c_str(),
+			eixrc["EPREFIX_INSTALLED"] + VAR_DB_PKG, &errtext))) {
+			cerr << errtext << endl;
+		}
+		if(override_umask) {
+			umask(old_umask);
+		}
+	}
 	statusline.success();
 	return EXIT_SUCCESS;
 }
 
 static void error_callback(const string& str) {
+	eix::MutexLocker locker(&output_mutex);
 	reading_percent_status->interprint_start();
 	cerr << str << endl;
 	reading_percent_status->interprint_end();
 }
 
+static void print_cache_info(const BasicCache *cache, Statusline *statusline) {
+	INFO(eix::format(_("[%s] %r %s (cache: %s)\n"))
+		% cache->getKey()
+		% cache->getOverlayName()
+		% cache->getPathHumanReadable()
+		% cache->getType());
+	statusline->print(eix::format(_("[%s] %s"))
+			% cache->getKey()
+			% cache->getOverlayName());
+}
+
+/** Data shared by the threads of read_parallel() */
+class ParallelRead {
+	public:
+		typedef vector<BasicCache *> CacheList;
+		typedef vector<PackageTree::const_iterator> CategoryList;
+
+		/// Each thread gets its own copy of the caches
+		vector<CacheList> workers;
+		vector<CacheList>::size_type next_worker;
+
+		CategoryList categories;
+		CategoryList::size_type next_category;
+
+		bool is_empty, aborted;
+
+		/// Protects all of the above
+		eix::Mutex mutex;
+
+		ParallelRead() : next_worker(0), next_category(0), is_empty(true), aborted(false) {
+		}
+};
+
+/** Read all categories from the caches [begin, end) in parallel threads.
+    The caches are read in their order for each category; since categories
+    are independent, the result is the same as for sequential reading. */
+static void read_parallel(CacheTable::iterator begin, CacheTable::iterator end, const PackageTree& package_tree) {
+	ParallelRead data;
+	data.workers.resize(jobs);
+	for(CacheTable::iterator it(begin); likely(it != end); ++it) {
+		data.workers[0].push_back(*it);
+		for(unsigned int i(1); likely(i != jobs); ++i) {
+			data.workers[i].push_back(it->clone());
+		}
+	}
+	for(PackageTree::const_iterator ci(package_tree.begin());
+		likely(ci != package_tree.end()); ++ci) {
+		data.categories.push_back(ci);
+	}
+
+	reading_percent_status = new PercentStatus;
+	if(use_percentage) {
+		reading_percent_status->init(
+			_("     Reading category %s|%s (%s%%)"),
+			package_tree.size());
+	} else {
+		reading_percent_status->init(eix::format(N_(
+			"     Reading %s category of packages .. ",
+			"     Reading up to %s categories of packages .. ",
+			package_tree.size()))
+			% package_tree.size());
+	}
+	eix::run_parallel(jobs, read_parallel_worker, &data);
+	string msg(unlikely(data.is_empty) ? _("EMPTY!") :
+		(unlikely(data.aborted) ? _("ABORTED!") :
+			_("Finished")));
+	if(use_percentage) {
+		msg.insert(string::size_type(0), 1, ' ');
+	}
+	reading_percent_status->finish(msg);
+	delete reading_percent_status;
+
+	for(vector<ParallelRead::CacheList>::size_type i(1);
+		likely(i < data.workers.size()); ++i) {
+		const ParallelRead::CacheList& clones(data.workers[i]);
+		for(ParallelRead::CacheList::const_iterator it(clones.begin());
+			likely(it != clones.end()); ++it) {
+			delete *it;
+		}
+	}
+}
+
+static void read_parallel_worker(void *data) {
+	ParallelRead *p(static_cast<ParallelRead *>(data));
+	p->mutex.lock();
+	const ParallelRead::CacheList& caches(p->workers[p->next_worker++]);
+	p->mutex.unlock();
+	for(;;) {
+		p->mutex.lock();
+		if(unlikely(p->next_category == p->categories.size())) {
+			p->mutex.unlock();
+			return;
+		}
+		PackageTree::const_iterator ci(p->categories[p->next_category++]);
+		p->mutex.unlock();
+
+		bool is_empty(true);
+		bool aborted(false);
+		for(ParallelRead::CacheList::const_iterator it(caches.begin());
+			likely(it != caches.end()); ++it) {
+			BasicCache *cache(*it);
+			if(cache->readCategoryPrepare(ci->first.c_str())) {
+				is_empty = false;
+				if(!cache->readCategory(ci->second)) {
+					aborted = true;
+				}
+			}
+			cache->readCategoryFinalize();
+		}
+
+		if(use_percentage) {
+			eix::MutexLocker locker(&output_mutex);
+			if(is_empty) {
+				reading_percent_status->next();
+			} else {
+				reading_percent_status->next(eix::format(_(": %s ..")) % ci->first);
+			}
+		}
+		if(!is_empty) {
+			eix::MutexLocker locker(&(p->mutex));
+			p->is_empty = false;
+			if(aborted) {
+				p->aborted = true;
+			}
+		}
+	}
+}
+
+/** Data shared by the threads of mask_parallel() and hash_parallel() */
+class ParallelCategories {
+	public:
+		typedef vector<Category *> CategoryList;
+
+		CategoryList categories;
+		CategoryList::size_type next_category;
+
+		/// Only for mask_parallel()
+		const PortageSettings *portage_settings;
+
+		/// Only for hash_parallel(): each thread gets its own partial hashes
+		vector<DBHeader> partial;
+		vector<DBHeader>::size_type next_partial;
+
+		/// Protects all of the above
+		eix::Mutex mutex;
+
+		explicit ParallelCategories(const PackageTree& package_tree) : next_category(0), portage_settings(NULLPTR), next_partial(0) {
+			for(PackageTree::const_iterator ci(package_tree.begin());
+				likely(ci != package_tree.end()); ++ci) {
+				categories.push_back(ci->second);
+			}
+		}
+
+		/// @return next category or NULLPTR if the queue is empty
+		Category *next() {
+			eix::MutexLocker locker(&mutex);
+			if(unlikely(next_category == categories.size())) {
+				return NULLPTR;
+			}
+			return categories[next_category++];
+		}
+};
+
+/** Apply the masks in parallel threads. Each package is handled by only one
+    thread. PortageSettings::setMasks() calls finalize() whose lazily
+    calculated list of world sets must be prepared before. */
+static void mask_parallel(const PackageTree& package_tree, PortageSettings *portage_settings) {
+	ParallelCategories data(package_tree);
+	data.portage_settings = portage_settings;
+	portage_settings->prepare_world_sets();
+	eix::run_parallel(jobs, mask_parallel_worker, &data);
+}
+
+static void mask_parallel_worker(void *data) {
+	ParallelCategories *p(static_cast<ParallelCategories *>(data));
+	const PortageSettings *portage_settings(p->portage_settings);
+	for(Category *ci(p->next()); likely(ci != NULLPTR); ci = p->next()) {
+		for(Category::iterator it(ci->begin()); likely(it != ci->end()); ++it) {
+			portage_settings->setMasks(*it);
+			it->save_maskflags(Version::SAVEMASK_FILE);
+		}
+	}
+}
+
+/** Calculate the hashes in parallel threads: Each thread counts the
+    frequencies for its categories in partial hashes which are summed up
+    at the end. The sum does not depend on the distribution of categories,
+    so the result is the same as for Database::prep_header_hashs(). */
+static void hash_parallel(DBHeader *dbheader, const PackageTree& package_tree) {
+	ParallelCategories data(package_tree);
+	data.partial.resize(jobs);
+	for(vector<DBHeader>::iterator it(data.partial.begin());
+		likely(it != data.partial.end()); ++it) {
+		Database::init_header_hashs(&(*it));
+	}
+	eix::run_parallel(jobs, hash_parallel_worker, &data);
+	Database::init_header_hashs(dbheader);
+	for(vector<DBHeader>::const_iterator it(data.partial.begin());
+		likely(it != data.partial.end()); ++it) {
+		Database::merge_header_hashs(dbheader, *it);
+	}
+	Database::finalize_header_hashs(dbheader);
+}
+
+static void hash_parallel_worker(void *data) {
+	ParallelCategories *p(static_cast<ParallelCategories *>(data));
+	p->mutex.lock();
+	DBHeader *partial(&(p->partial[p->next_partial++]));
+	p->mutex.unlock();
+	for(Category *ci(p->next()); likely(ci != NULLPTR); ci = p->next()) {
+		Database::hash_category(partial, *ci);
+	}
+}
+
+/** Store the fingerprint of the configuration and of all categories for
+    which all caches can provide a reliable fingerprint in dbheader.
+    The configuration consists of everything which influences what the
+    caches yield: DEP, the eixrc variables CACHE_METHOD_PARSE and EAPI_REGEX,
+    the eclass locations, and the method, path, and name of each cache. */
+static void calc_fingerprints(DBHeader *dbheader, CacheTable *cache_table, const PackageTree& package_tree, const PortageSettings& portage_settings) {
+	dbheader->use_fingerprints = true;
+	string& config(dbheader->config_fingerprint);
+	config.assign(Depend::use_depend ? "DEP\n" : "\n");
+	EixRc& eixrc(get_eixrc());
+	config.append(eix::format("%s\t%s\t%s\n")
+		% eixrc["CACHE_METHOD_PARSE"]
+		% eixrc["EAPI_REGEX"]
+		% portage_settings["PORTDIR"]);
+	for(RepoList::const_iterator it(portage_settings.repos.begin());
+		likely(it != portage_settings.repos.end()); ++it) {
+		config.append(it->path);
+		config.append(1, '\t');
+	}
+	config.append(1, '\n');
+	for(CacheTable::const_iterator it(cache_table->begin());
+		likely(it != cache_table->end()); ++it) {
+		config.append(eix::format("%s\t%s\t%s\t%s\n")
+			% it->getKey()
+			% it->getType()
+			% it->getPrefixedPath()
+			% it->getOverlayName());
+	}
+	WordMap& fingerprints(dbheader->category_fingerprints);
+	fingerprints.clear();
+	for(PackageTree::const_iterator ci(package_tree.begin());
+		likely(ci != package_tree.end()); ++ci) {
+		string fingerprint;
+		CacheTable::iterator it(cache_table->begin());
+		for(; likely(it != cache_table->end()); ++it) {
+			string cache_fingerprint;
+			if(!it->get_fingerprint(ci->first.c_str(), &cache_fingerprint)) {
+				break;
+			}
+			fingerprint.append(cache_fingerprint);
+			fingerprint.append(1, '\n');
+		}
+		if(it == cache_table->end()) {
+			fingerprints[ci->first] = fingerprint;
+		}
+	}
+}
+
+/** Read all categories whose fingerprints are the same as in the previous
+    database from that database into package_tree.
+    Their names are stored in reused. */
+static void reuse_categories(const char *outputfile, const DBHeader& dbheader, PackageTree *package_tree, WordVec *reused) {
+	Database db;
+	if(!db.openread(outputfile)) {
+		return;
+	}
+	DBHeader old_header;
+	string errtext;
+	if(!(db.read_header(&old_header, &errtext) &&
+		old_header.use_fingerprints &&
+		db.read_fingerprints(&old_header, &errtext) &&
+		(old_header.config_fingerprint == dbheader.config_fingerprint) &&
+		db.read_index(&old_header, &errtext))) {
+		return;
+	}
+	WordSet reused_set;
+	IndexSelection selection;
+	const WordMap& old_fingerprints(old_header.category_fingerprints);
+	for(WordMap::const_iterator it(dbheader.category_fingerprints.begin());
+		likely(it != dbheader.category_fingerprints.end()); ++it) {
+		WordMap::const_iterator old(old_fingerprints.find(it->first));
+		if((old == old_fingerprints.end()) || (old->second != it->second)) {
+			continue;
+		}
+		reused->push_back(it->first);
+		reused_set.insert(it->first);
+		if(old_header.use_index) {
+			old_header.select_category(&selection, it->first);
+		}
+	}
+	if(reused->empty()) {
+		return;
+	}
+
+	PackageReader reader(&db, old_header);
+	if(old_header.use_index) {
+		sort(selection.begin(), selection.end());
+		reader.select(&selection);
+	}
+	while(reader.next()) {
+		if(reused_set.find(reader.category()) == reused_set.end()) {
+			if(unlikely(!reader.skip())) {
+				break;
+			}
+			continue;
+		}
+		Package *pkg(reader.release());
+		if(unlikely(pkg == NULLPTR)) {
+			break;
+		}
+		// The masks are calculated again as for freshly read packages
+		for(Package::iterator v(pkg->begin()); likely(v != pkg->end()); ++v) {
+			v->maskflags.set(MaskFlags::MASK_NONE);
+		}
+		(*package_tree)[pkg->category].addPackage(pkg);
+	}
+	if(unlikely(reader.get_errtext() != NULLPTR)) {
+		cerr << eix::format(_("cannot reuse categories from %s: %s"))
+			% outputfile % reader.get_errtext() << endl;
+		for(WordVec::const_iterator it(reused->begin());
+			likely(it != reused->end()); ++it) {
+			(*package_tree)[*it].delete_and_clear();
+		}
+		reused->clear();
+	}
+}
+
+/** Move the categories with the given names (with their packages) */
+static void move_categories(PackageTree *from, PackageTree *to, const WordVec& names) {
+	for(WordVec::const_iterator it(names.begin()); likely(it != names.end()); ++it) {
+		PackageTree::Categories::iterator c(from->Categories::find(*it));
+		to->Categories::insert(*c);
+		from->Categories::erase(c);
+	}
+}
+
 static bool update(const char *outputfile, CacheTable *cache_table, PortageSettings *portage_settings, bool override_umask, const RepoNames& repo_names, const WordVec& exclude_labels, Statusline *statusline, string *errtext) {
 	DBHeader dbheader;
 	WordVec categories;
@@ -564,6 +965,7 @@ static bool update(const char *outputfile, CacheTable *cache_table, PortageSetti
 	PackageTree package_tree(categories);
 
 	dbheader.world_sets = *(portage_settings->get_world_sets());
+	dbheader.profile_fingerprint = portage_settings->profile_fingerprint();
 
 	/* We must first initialize all caches and erase unneeded ones,
 	   because some cache methods like eixcache know about each other
@@ -593,21 +995,42 @@ static bool update(const char *outputfile, CacheTable *cache_table, PortageSetti
 		if(verbose) {
 			cache->setVerbose();
 		}
+		cache->setJobs(jobs);
 		++it;
 	}
 
+	/* Take unchanged categories from the previous database */
+	PackageTree reused_tree;
+	WordVec reused;
+	if(incremental) {
+		calc_fingerprints(&dbheader, cache_table, package_tree, *portage_settings);
+		reuse_categories(outputfile, dbheader, &package_tree, &reused);
+		if(!reused.empty()) {
+			INFO(eix::format(N_(
+				"Reusing %s unchanged category from %s\n",
+				"Reusing %s unchanged categories from %s\n",
+				reused.size()))
+				% reused.size() % outputfile);
+			// Hide them from the caches while reading
+			move_categories(&package_tree, &reused_tree, reused);
+		}
+	}
+
 	/* Build database from scratch. */
 	for(CacheTable::iterator it(cache_table->begin());
 		likely(it != cache_table->end()); ++it) {
 		BasicCache *cache(*it);
-		INFO(eix::format(_("[%s] %r %s (cache: %s)\n"))
-			% cache->getKey()
-			% cache->getOverlayName()
-			% cache->getPathHumanReadable()
-			% cache->getType());
-		statusline->print(eix::format(_("[%s] %s"))
-				% cache->getKey()
-				% cache->getOverlayName());
+		if((jobs > 1) && cache->can_read_parallel()) {
+			// Read all subsequent caches which support it in parallel
+			CacheTable::iterator end(it);
+			do {
+				print_cache_info(*end, statusline);
+			} while((++end != cache_table->end()) && end->can_read_parallel());
+			read_parallel(it, end, package_tree);
+			it = --end;
+			continue;
+		}
+		print_cache_info(cache, statusline);
 		reading_percent_status = new PercentStatus;
 		if(cache->can_read_multiple_categories()) {
 			reading_percent_status->init(_("     Reading Packages .. "));
@@ -658,22 +1081,31 @@ static bool update(const char *outputfile, CacheTable *cache_table, PortageSetti
 		}
 		delete reading_percent_status;
 	}
+	move_categories(&reused_tree, &package_tree, reused);
 	statusline->print(eix::format(_("Analyzing")));
 
 	/* Now apply all masks .. */
 	INFO(_("Applying masks ..\n"));
-	for(PackageTree::iterator c(package_tree.begin());
-		likely(c != package_tree.end()); ++c) {
-		Category *ci = c->second;
-		for(Category::iterator p(ci->begin());
-			likely(p != ci->end()); ++p) {
-			portage_settings->setMasks(*p);
-			p->save_maskflags(Version::SAVEMASK_FILE);
+	if(jobs > 1) {
+		mask_parallel(package_tree, portage_settings);
+	} else {
+		for(PackageTree::iterator c(package_tree.begin());
+			likely(c != package_tree.end()); ++c) {
+			Category *ci = c->second;
+			for(Category::iterator p(ci->begin());
+				likely(p != ci->end()); ++p) {
+				portage_settings->setMasks(*p);
+				p->save_maskflags(Version::SAVEMASK_FILE);
+			}
 		}
 	}
 
 	INFO(_("Calculating hash tables ..\n"));
-	Database::prep_header_hashs(&dbheader, package_tree);
+	if(jobs > 1) {
+		hash_parallel(&dbheader, package_tree);
+	} else {
+		Database::prep_header_hashs(&dbheader, package_tree);
+	}
 
 	/* And write database back to disk .. */
 	statusline->print(eix::format("Creating %s") % outputfile);
@@ -693,9 +1125,17 @@ static bool update(const char *outputfile, CacheTable *cache_table, PortageSetti
 	}
 
 	dbheader.size = package_tree.countCategories();
+	if(likely(category_index)) {
+		db.prep_category_index(&dbheader, package_tree);
+		// The trigram index refers to the packages by the category index
+		if(trigram_index) {
+			Database::prep_trigram_index(&dbheader, package_tree);
+		}
+	}
 
 	if(!(likely(db.write_header(dbheader, errtext)) &&
-		likely(db.write_packagetree(package_tree, dbheader, errtext)))) {
+		likely(db.write_packagetree(package_tree, dbheader, errtext)) &&
+		likely(db.commit(errtext)))) {
 		return false;
 	}
 
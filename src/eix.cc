@@ -17,9 +17,12 @@
 #include <iostream>
 #include <map>
 #include <string>
+#include <vector>
 
 #include "database/header.h"
 #include "database/package_reader.h"
+#include "database/trigrams.h"
+#include "database/vardb_index.h"
 #include "eixTk/ansicolor.h"
 #include "eixTk/argsreader.h"
 #include "eixTk/diagnostics.h"
@@ -30,10 +33,12 @@
 #include "eixTk/i18n.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
+#include "eixTk/outputsink.h"
 #include "eixTk/outputstring.h"
 #include "eixTk/ptr_list.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
+#include "eixTk/threads.h"
 #include "eixTk/utils.h"
 #include "eixrc/eixrc.h"
 #include "eixrc/global.h"
@@ -56,24 +61,27 @@
 #include "various/drop_permissions.h"
 #include "various/cli.h"
 
-#define VAR_DB_PKG "/var/db/pkg/"
-
 template<typename m_Type> class MaskList;
 
 using std::map;
 using std::string;
+using std::vector;
 
 using std::cerr;
 using std::cout;
 using std::endl;
 
 static void dump_help();
-static bool opencache(Database *db, const char *filename, const char *tooltext) ATTRIBUTE_NONNULL_;
+static bool opencache(Database *db, const char *filename, const char *tooltext, bool use_mmap) ATTRIBUTE_NONNULL_;
 static bool print_overlay_table(PrintFormat *fmt, DBHeader *header, PrintFormat::OverlayUsed *overlay_used) ATTRIBUTE_NONNULL((1, 2));
 static void parseFormat(const char *sourcename, const char *content) ATTRIBUTE_NONNULL_;
 static void set_format(EixRc *rc) ATTRIBUTE_NONNULL_;
 static void setup_defaults(EixRc *rc, bool is_tty) ATTRIBUTE_NONNULL_;
 static bool is_current_dbversion(const char *filename, const char *tooltext) ATTRIBUTE_NONNULL_;
+#ifdef WITH_THREADS
+static bool match_parallel(unsigned int jobs, Database *db, const DBHeader& header, PortageSettings *portagesettings, MatchTree *matchtree, const IndexSelection *selection, eix::ptr_list<Package> *matches) ATTRIBUTE_NONNULL((2, 4, 5, 7));
+static void match_parallel_worker(void *data) ATTRIBUTE_NONNULL_;
+#endif
 static void print_wordvec(const WordVec& vec);
 static void print_unused(const string& filename, const string& excludefiles, const eix::ptr_list<Package>& packagelist, bool test_empty);
 static void print_removed(const string& dirname, const string& excludefiles, const eix::ptr_list<Package>& packagelist);
@@ -705,6 +713,9 @@ int run_eix(int argc, char** argv) {
 		}
 	}
 
+	// From now on, stdout is only written through std::cout
+	OutputSink::redirect_cout();
+
 	bool only_printed;
 
 	if(unlikely(rc_options.xml)) {
@@ -739,12 +750,13 @@ int run_eix(int argc, char** argv) {
 		eixrc.getBool("CARE_RESTRICT_INSTALLED"),
 		eixrc.getBool("USE_BUILD_TIME"));
 	varpkg_db.check_installed_overlays = eixrc.getBoolText("CHECK_INSTALLED_OVERLAYS", "repository");
+	varpkg_db.useIndex(eixrc["VARDB_INDEX"]);
 
 	MaskList<Mask> *marked_list(NULLPTR);
 
 	/* Open database file */
 	Database db;
-	if(unlikely(!opencache(&db, cachefile.c_str(), tooltext))) {
+	if(unlikely(!opencache(&db, cachefile.c_str(), tooltext, true))) {
 		return EXIT_FAILURE;
 	}
 	DBHeader header;
@@ -813,9 +825,53 @@ int run_eix(int argc, char** argv) {
 	MatchTree *matchtree = new MatchTree(eixrc.getBool("DEFAULT_IS_OR"));
 	parse_cli(matchtree, &eixrc, &varpkg_db, &portagesettings, format, &stability, &header, &marked_list, argreader);
 
+	// With the category index we need not read packages which cannot match
+	IndexSelection selection;
+	bool use_selection(false);
+	if(header.use_index && !rc_options.test_unused) {
+		string errtext;
+		if(unlikely(!db.read_index(&header, &errtext))) {
+			cerr << errtext << endl;
+			return EXIT_FAILURE;
+		}
+		// Substring tests can select candidates with the trigram index
+		if(header.use_trigrams) {
+			TrigramSet trigrams;
+			matchtree->get_trigrams(&trigrams);
+			if(!trigrams.empty() &&
+				unlikely(!db.read_trigrams(&header, trigrams, &errtext))) {
+				cerr << errtext << endl;
+				return EXIT_FAILURE;
+			}
+		}
+		use_selection = matchtree->get_selection(&selection);
+	}
+
 	eix::ptr_list<Package> matches;
-	eix::ptr_list<Package> all_packages; {
+	eix::ptr_list<Package> all_packages;
+#ifdef WITH_THREADS
+	// The packages can be decoded and tested in parallel threads if each
+	// thread can read the database with an own position, and if the tests
+	// need no lazily calculated data. The order of the matches is kept.
+	unsigned int jobs(eixrc.getInteger("SEARCH_JOBS"));
+	if(jobs == 0) {
+		jobs = eix::available_processors();
+	}
+	if((jobs > 1) && header.use_index && db.is_mapped() &&
+		!rc_options.test_unused &&
+		!(only_printed && (rc_options.brief || rc_options.brief2)) &&
+		matchtree->can_match_parallel()) {
+		if(unlikely(!match_parallel(jobs, &db, header, &portagesettings,
+			matchtree, (use_selection ? &selection : NULLPTR), &matches))) {
+			return EXIT_FAILURE;
+		}
+	} else
+#endif
+	{
 		PackageReader reader(&db, header, &portagesettings);
+		if(use_selection) {
+			reader.select(&selection);
+		}
 		bool add_rest(false);
 		while(likely(reader.next())) {
 			if(unlikely(add_rest)) {
@@ -938,6 +994,13 @@ int run_eix(int argc, char** argv) {
 	bool reached_limit(false), over_limit(false);
 	string limit_var(rc_options.compact_output ? "EIX_LIMIT_COMPACT" : "EIX_LIMIT");
 	eix::Treesize limit(is_tty ? eixrc.getInteger(limit_var) : 0);
+#ifdef WITH_THREADS
+	// Read the files of the installed versions to be printed in parallel
+	if((jobs > 1) && !rc_options.be_quiet &&
+		!rc_options.brief && !rc_options.brief2) {
+		varpkg_db.prefetch(matches, limit, jobs);
+	}
+#endif
 	for(eix::ptr_list<Package>::iterator it(matches.begin());
 		likely(it != matches.end()); ++it) {
 		stability.set_stability(*it);
@@ -1074,8 +1137,8 @@ GCC_DIAG_ON(sign-conversion)
 	return EXIT_SUCCESS;
 }  // NOLINT(readability/fn_size)
 
-static bool opencache(Database *db, const char *filename, const char *tooltext) {
-	if(likely(db->openread(filename))) {
+static bool opencache(Database *db, const char *filename, const char *tooltext, bool use_mmap) {
+	if(likely(db->openread(filename, use_mmap))) {
 		return true;
 	}
 	cerr << eix::format(_(
@@ -1085,8 +1148,129 @@ static bool opencache(Database *db, const char *filename, const char *tooltext)
 	return false;
 }
 
+#ifdef WITH_THREADS
+/** The data shared by the threads of match_parallel() */
+class ParallelMatch {
+	public:
+		typedef vector<IndexSelection> Chunks;
+
+		Database *db;
+		const DBHeader *header;
+		PortageSettings *portagesettings;
+		MatchTree *matchtree;
+
+		/// The packages to test, split into chunks in database order
+		Chunks chunks;
+
+		/// The matches of each chunk
+		vector<vector<Package *> > results;
+
+		string errtext;
+		bool error;
+
+		ParallelMatch() : error(false), m_next(0) {
+		}
+
+		/// @return false if there is no chunk left (or an error occurred)
+		bool next(Chunks::size_type *i) ATTRIBUTE_NONNULL_ {
+			eix::MutexLocker locker(&mutex);
+			if(unlikely(error || (m_next == chunks.size()))) {
+				return false;
+			}
+			*i = m_next++;
+			return true;
+		}
+
+		void set_error(const char *err) ATTRIBUTE_NONNULL_ {
+			eix::MutexLocker locker(&mutex);
+			if(!error) {
+				error = true;
+				errtext = err;
+			}
+		}
+
+	private:
+		Chunks::size_type m_next;
+		eix::Mutex mutex;
+};
+
+/** Test the packages of selection (or all packages if selection is NULLPTR)
+    in parallel threads and append the matches to *matches.
+    Each thread reads the packages of a chunk through an own Database object
+    sharing the mapping of db, so reading needs no locking.
+    @return false (after printing an error message) if reading failed */
+static bool match_parallel(unsigned int jobs, Database *db, const DBHeader& header, PortageSettings *portagesettings, MatchTree *matchtree, const IndexSelection *selection, eix::ptr_list<Package> *matches) {
+	static const IndexSelection::size_type chunk_size = 256;
+	ParallelMatch data;
+	data.db = db;
+	data.header = &header;
+	data.portagesettings = portagesettings;
+	data.matchtree = matchtree;
+	if(selection != NULLPTR) {
+		for(IndexSelection::const_iterator it(selection->begin());
+			likely(it != selection->end()); ++it) {
+			if((data.chunks.empty()) || (data.chunks.back().size() == chunk_size)) {
+				data.chunks.push_back(IndexSelection());
+			}
+			data.chunks.back().push_back(*it);
+		}
+	} else {
+		for(CategoryIndex::size_type c(0); likely(c != header.category_index.size()); ++c) {
+			PackageIndex::size_type s(header.category_index[c].packages.size());
+			for(PackageIndex::size_type i(0); likely(i != s); ++i) {
+				if((data.chunks.empty()) || (data.chunks.back().size() == chunk_size)) {
+					data.chunks.push_back(IndexSelection());
+				}
+				data.chunks.back().push_back(IndexPosition(c, i));
+			}
+		}
+	}
+	data.results.resize(data.chunks.size());
+	// PackageReader::read() calls PortageSettings::finalize()
+	portagesettings->prepare_world_sets();
+	eix::run_parallel(jobs, match_parallel_worker, &data);
+	for(vector<vector<Package *> >::const_iterator it(data.results.begin());
+		likely(it != data.results.end()); ++it) {
+		matches->insert(matches->end(), it->begin(), it->end());
+	}
+	if(unlikely(data.error)) {
+		cerr << data.errtext << endl;
+		return false;
+	}
+	return true;
+}
+
+static void match_parallel_worker(void *data) {
+	ParallelMatch *p(static_cast<ParallelMatch *>(data));
+	Database db;
+	db.openread(*(p->db));
+	PackageReader reader(&db, *(p->header), p->portagesettings);
+	ParallelMatch::Chunks::size_type i;
+	while(p->next(&i)) {
+		vector<Package *> *result(&(p->results[i]));
+		reader.select(&(p->chunks[i]));
+		while(likely(reader.next())) {
+			if(unlikely(p->matchtree->match(&reader))) {
+				Package *release(reader.release());
+				if(unlikely(release == NULLPTR)) {
+					break;
+				}
+				result->push_back(release);
+			} else if(unlikely(!reader.skip())) {
+				break;
+			}
+		}
+		const char *err_cstr(reader.get_errtext());
+		if(unlikely(err_cstr != NULLPTR)) {
+			p->set_error(err_cstr);
+			return;
+		}
+	}
+}
+#endif
+
 static bool is_current_dbversion(const char *filename, const char *tooltext) { 	Database db;
-	if(unlikely(!opencache(&db, filename, tooltext))) {
+	if(unlikely(!opencache(&db, filename, tooltext, false))) {
 		return false;
 	}
 	DBHeader header;
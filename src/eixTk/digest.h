@@ -0,0 +1,57 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#ifndef SRC_EIXTK_DIGEST_H_
+#define SRC_EIXTK_DIGEST_H_ 1
+
+#include <string>
+
+#include "eixTk/inttypes.h"
+#include "eixTk/likely.h"
+
+/** A 64 bit FNV-1a hash of a sequence of numbers and strings.
+    It is not cryptographic; it only serves to detect changes. */
+class Digest {
+	public:
+		Digest() : m_hash((static_cast<uint64_t>(0xCBF29CE4U) << 32) | 0x84222325U) {
+		}
+
+		/// Feed the 8 bytes of num
+		void add(uint64_t num) {
+			for(unsigned int i(0); i != 8; ++i, num >>= 8) {
+				add_byte(static_cast<unsigned char>(num & 0xFFU));
+			}
+		}
+
+		/// Feed str with its terminating '\0'
+		void add(const std::string& str) {
+			const char *s(str.c_str());
+			do {
+				add_byte(static_cast<unsigned char>(*s));
+			} while(*(s++) != '\0');
+		}
+
+		/// @return the 8 bytes of the hash, most significant first
+		std::string get() const {
+			std::string ret(8, '\0');
+			uint64_t hash(m_hash);
+			for(std::string::size_type i(8); likely(i-- != 0); hash >>= 8) {
+				ret[i] = static_cast<char>(hash & 0xFFU);
+			}
+			return ret;
+		}
+
+	private:
+		uint64_t m_hash;
+
+		void add_byte(unsigned char c) {
+			m_hash ^= c;
+			m_hash *= ((static_cast<uint64_t>(1) << 40) | 0x1B3U);
+		}
+};
+
+#endif  // SRC_EIXTK_DIGEST_H_
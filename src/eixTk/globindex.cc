@@ -0,0 +1,115 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#include <config.h>
+
+#include <fnmatch.h>
+
+#include <algorithm>
+#include <string>
+
+#include "eixTk/globindex.h"
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+#include "eixTk/unused.h"
+
+using std::sort;
+using std::string;
+
+class PatternLess {
+	private:
+		const GlobIndex *index;
+
+	public:
+		explicit PatternLess(const GlobIndex *i) : index(i) {
+		}
+
+		bool operator()(GlobIndex::Index a, GlobIndex::Index b) const {
+			return ((*index)[a] < (*index)[b]);
+		}
+};
+
+static bool push_index(void *data, GlobIndex::Index i);
+static bool stop_walk(void *data, GlobIndex::Index i);
+
+GlobIndex::Index GlobIndex::add(const string& pattern) {
+	Index num(patterns.size());
+	patterns.push_back(pattern);
+	if(nodes.empty()) {
+		nodes.push_back(Node());
+	}
+	// Without FNM_PERIOD, the literal prefix must match exactly
+	string::size_type len(pattern.find_first_of("*?[\\"));
+	if(len == string::npos) {
+		len = pattern.size();
+	}
+	Index curr(0);
+	for(string::size_type i(0); likely(i != len); ++i) {
+		Node::Children::const_iterator it(nodes[curr].children.find(pattern[i]));
+		if(it != nodes[curr].children.end()) {
+			curr = it->second;
+			continue;
+		}
+		Index next(nodes.size());
+		nodes.push_back(Node());
+		nodes[curr].children[pattern[i]] = next;
+		curr = next;
+	}
+	nodes[curr].here.push_back(num);
+	return num;
+}
+
+bool GlobIndex::walk(const string& name, bool (*func)(void *data, Index i), void *data) const {
+	if(nodes.empty()) {
+		return true;
+	}
+	const char *s(name.c_str());
+	Index curr(0);
+	for(string::size_type i(0); ; ++i) {
+		const Node& node(nodes[curr]);
+		for(Result::const_iterator it(node.here.begin());
+			it != node.here.end(); ++it) {
+			// The first i characters are the (matching) literal prefix
+			if(fnmatch(patterns[*it].c_str() + i, s + i, FNM_PATHNAME) == 0) {
+				if(!(*func)(data, *it)) {
+					return false;
+				}
+			}
+		}
+		if(i == name.size()) {
+			return true;
+		}
+		Node::Children::const_iterator it(node.children.find(s[i]));
+		if(it == node.children.end()) {
+			return true;
+		}
+		curr = it->second;
+	}
+}
+
+static bool push_index(void *data, GlobIndex::Index i) {
+	static_cast<GlobIndex::Result *>(data)->push_back(i);
+	return true;
+}
+
+void GlobIndex::match(Result *result, const string& name) const {
+	result->clear();
+	walk(name, push_index, result);
+	if(unlikely(result->size() > 1)) {
+		sort(result->begin(), result->end(), PatternLess(this));
+	}
+}
+
+static bool stop_walk(void *data ATTRIBUTE_UNUSED, GlobIndex::Index i ATTRIBUTE_UNUSED) {
+	UNUSED(data);
+	UNUSED(i);
+	return false;
+}
+
+bool GlobIndex::matches(const string& name) const {
+	return !walk(name, stop_walk, NULLPTR);
+}
@@ -0,0 +1,70 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#ifndef SRC_EIXTK_GLOBINDEX_H_
+#define SRC_EIXTK_GLOBINDEX_H_ 1
+
+#include <map>
+#include <string>
+#include <vector>
+
+/** A collection of fnmatch(FNM_PATHNAME) patterns which are stored in a
+    trie of their literal prefixes (up to the first special character).
+    Hence, a name is only tested against the patterns whose literal prefix
+    it starts with, and fnmatch() needs to check only the remainder. */
+class GlobIndex {
+	public:
+		/** The number of a pattern in the order of add() */
+		typedef std::vector<std::string>::size_type Index;
+		typedef std::vector<Index> Result;
+
+		GlobIndex() {
+		}
+
+		bool empty() const {
+			return patterns.empty();
+		}
+
+		void clear() {
+			patterns.clear();
+			nodes.clear();
+		}
+
+		const std::string& operator[](Index i) const {
+			return patterns[i];
+		}
+
+		/** @return the number of the added pattern */
+		Index add(const std::string& pattern);
+
+		/** Set *result to the numbers of all patterns matching name,
+		    sorted alphabetically by the patterns */
+		void match(Result *result, const std::string& name) const ATTRIBUTE_NONNULL_;
+
+		/** @return true if some pattern matches name */
+		bool matches(const std::string& name) const;
+
+	private:
+		class Node {
+			public:
+				/** The numbers of the child nodes */
+				typedef std::map<char, Index> Children;
+				Children children;
+				Result here;
+		};
+		typedef std::vector<Node> Nodes;
+
+		std::vector<std::string> patterns;
+		Nodes nodes;
+
+		/** Call func(data, number) for each pattern matching name
+		    until func returns false.
+		    @return false if func has returned false */
+		bool walk(const std::string& name, bool (*func)(void *data, Index i), void *data) const ATTRIBUTE_NONNULL((3));
+};
+
+#endif  // SRC_EIXTK_GLOBINDEX_H_
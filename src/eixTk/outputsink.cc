@@ -0,0 +1,125 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#include <config.h>
+
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <iostream>
+
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+#include "eixTk/outputsink.h"
+
+using std::size_t;
+
+using std::cout;
+
+const size_t OutputSink::buffer_size;
+
+static void flush_cout();
+
+OutputSink::OutputSink(int fd) : m_fd(fd), m_tty(isatty(fd) != 0), m_buffer(new char[buffer_size]) {
+	setp(m_buffer, m_buffer + buffer_size);
+}
+
+OutputSink::~OutputSink() {
+	sync();
+	delete[] m_buffer;
+}
+
+OutputSink::int_type OutputSink::overflow(int_type c) {
+	if(unlikely(traits_type::eq_int_type(c, traits_type::eof()))) {
+		return ((sync() == 0) ? traits_type::not_eof(c) : traits_type::eof());
+	}
+	if((pptr() == epptr()) && unlikely(!write_out(NULLPTR, 0))) {
+		return traits_type::eof();
+	}
+	*pptr() = traits_type::to_char_type(c);
+	pbump(1);
+	if(unlikely(m_tty) && (c == '\n') && unlikely(!write_out(NULLPTR, 0))) {
+		return traits_type::eof();
+	}
+	return c;
+}
+
+std::streamsize OutputSink::xsputn(const char *s, std::streamsize n) {
+	size_t len(n);
+	if(likely(len <= static_cast<size_t>(epptr() - pptr()))) {
+		memcpy(pptr(), s, len);
+		pbump(static_cast<int>(len));
+		if(likely(!m_tty) || (memchr(s, '\n', len) == NULLPTR)) {
+			return n;
+		}
+		s = NULLPTR;
+		len = 0;
+	}
+	return (write_out(s, len) ? n : 0);
+}
+
+int OutputSink::sync() {
+	return (write_out(NULLPTR, 0) ? 0 : -1);
+}
+
+bool OutputSink::write_out(const char *s, size_t len) {
+	struct iovec iov[2];
+	iov[0].iov_base = pbase();
+	iov[0].iov_len = pptr() - pbase();
+	iov[1].iov_base = const_cast<char *>(s);
+	iov[1].iov_len = len;
+	setp(m_buffer, m_buffer + buffer_size);
+	struct iovec *curr(iov);
+	int count(2);
+	while(likely(count != 0)) {
+		if(curr->iov_len == 0) {
+			++curr;
+			--count;
+			continue;
+		}
+		ssize_t written(writev(m_fd, curr, count));
+		if(unlikely(written < 0)) {
+			if(errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		size_t done(written);
+		while(done >= curr->iov_len) {
+			done -= curr->iov_len;
+			++curr;
+			if(--count == 0) {
+				return true;
+			}
+		}
+		curr->iov_base = static_cast<char *>(curr->iov_base) + done;
+		curr->iov_len -= done;
+	}
+	return true;
+}
+
+static void flush_cout() {
+	cout.flush();
+}
+
+void OutputSink::redirect_cout() {
+	static OutputSink *sink(NULLPTR);
+	if(sink != NULLPTR) {
+		return;
+	}
+	fflush(stdout);
+	sink = new OutputSink(fileno(stdout));
+	cout.rdbuf(sink);
+	atexit(flush_cout);
+}
@@ -0,0 +1,51 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#ifndef SRC_EIXTK_OUTPUTSINK_H_
+#define SRC_EIXTK_OUTPUTSINK_H_ 1
+
+#include <cstddef>
+
+#include <streambuf>
+
+/** A streambuf writing to a file descriptor through a large buffer.
+    The buffer is written only when it is full, on explicit flushes,
+    or at the end of each line if the file descriptor is a terminal.
+    Data which does not fit is written together with the buffer by a
+    single writev() without copying. */
+class OutputSink : public std::streambuf {
+	public:
+		static const std::size_t buffer_size = 128 * 1024;
+
+		explicit OutputSink(int fd);
+
+		~OutputSink();
+
+		/** Let std::cout write to stdout through an OutputSink.
+		    Since the sink is never freed, std::cout is flushed at exit.
+		    Previous output of stdio to stdout is flushed first;
+		    after this call, stdio must not be used for stdout anymore. */
+		static void redirect_cout();
+
+	protected:
+		int_type overflow(int_type c);
+
+		std::streamsize xsputn(const char *s, std::streamsize n);
+
+		int sync();
+
+	private:
+		int m_fd;
+		bool m_tty;
+		char *m_buffer;
+
+		/** Write the buffer and then len bytes of s.
+		    @return false on a write error */
+		bool write_out(const char *s, std::size_t len);
+};
+
+#endif  // SRC_EIXTK_OUTPUTSINK_H_
@@ -0,0 +1,76 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#include <config.h>
+
+#include <cstddef>
+
+#include <new>
+
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+#include "eixTk/pool.h"
+#include "eixTk/threads.h"
+
+namespace eix {
+
+/** The block sizes are multiples of the alignment of this type */
+union PoolAlign {
+	void *p;
+	double d;
+	long l;
+};
+
+static const std::size_t pool_granularity = sizeof(PoolAlign);
+static const std::size_t pool_classes = 128;
+static const std::size_t pool_max_size = pool_granularity * pool_classes;
+static const std::size_t pool_chunk_size = 64 * 1024;
+
+/** The heads of the free lists of each size class.
+    The list pointer is stored in the first bytes of a free block.
+    The lists are thread local so that no locking is required;
+    a block freed by a different thread than it was allocated simply
+    changes its owner. Free blocks of an exited thread are lost. */
+static THREAD_LOCAL void *free_blocks[pool_classes + 1];
+
+/** The unused part of the current chunk */
+static THREAD_LOCAL char *chunk_begin = NULLPTR, *chunk_end = NULLPTR;
+
+void *pool_allocate(std::size_t size) {
+	if(unlikely(size > pool_max_size)) {
+		return ::operator new(size);
+	}
+	std::size_t c((size + pool_granularity - 1) / pool_granularity);
+	void *p(free_blocks[c]);
+	if(likely(p != NULLPTR)) {
+		free_blocks[c] = *static_cast<void **>(p);
+		return p;
+	}
+	size = ((c == 0) ? 1 : c) * pool_granularity;
+	if(unlikely(static_cast<std::size_t>(chunk_end - chunk_begin) < size)) {
+		chunk_begin = static_cast<char *>(::operator new(pool_chunk_size));
+		chunk_end = chunk_begin + pool_chunk_size;
+	}
+	p = chunk_begin;
+	chunk_begin += size;
+	return p;
+}
+
+void pool_deallocate(void *p, std::size_t size) {
+	if(unlikely(p == NULLPTR)) {
+		return;
+	}
+	if(unlikely(size > pool_max_size)) {
+		::operator delete(p);
+		return;
+	}
+	std::size_t c((size + pool_granularity - 1) / pool_granularity);
+	*static_cast<void **>(p) = free_blocks[c];
+	free_blocks[c] = p;
+}
+
+}  // namespace eix
@@ -0,0 +1,120 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#ifndef SRC_EIXTK_POOL_H_
+#define SRC_EIXTK_POOL_H_ 1
+
+#include <cstddef>
+
+#include <limits>
+#include <new>
+
+#include "eixTk/null.h"
+#include "eixTk/unused.h"
+
+namespace eix {
+
+/** Allocate size bytes from chunks of memory which are split into blocks.
+    This is much cheaper in time and space than operator new for the huge
+    number of small objects (versions, list and set nodes) of a package tree.
+    Freed blocks are kept in a free list of the calling thread for reuse;
+    the chunks are never returned to the system.
+    Large sizes are simply passed to operator new. */
+void *pool_allocate(std::size_t size);
+
+/** Free a block obtained from pool_allocate(size) */
+void pool_deallocate(void *p, std::size_t size);
+
+/** Derive from this to allocate single objects of the class from the pool.
+    Derived classes must have a virtual destructor if they are deleted
+    through a pointer to a base class. */
+class Pooled {
+	public:
+		static void *operator new(std::size_t size) {
+			return pool_allocate(size);
+		}
+
+		static void operator delete(void *p, std::size_t size) {
+			pool_deallocate(p, size);
+		}
+};
+
+/** A standard allocator which takes single elements (e.g. the nodes of
+    std::list or std::set) from the pool */
+template<typename T> class PoolAllocator {
+	public:
+		typedef T value_type;
+		typedef T *pointer;
+		typedef const T *const_pointer;
+		typedef T& reference;
+		typedef const T& const_reference;
+		typedef std::size_t size_type;
+		typedef std::ptrdiff_t difference_type;
+
+		template<typename U> struct rebind {
+			typedef PoolAllocator<U> other;
+		};
+
+		PoolAllocator() {
+		}
+
+		template<typename U> PoolAllocator(const PoolAllocator<U>& other ATTRIBUTE_UNUSED) {
+			UNUSED(other);
+		}
+
+		pointer address(reference x) const {
+			return &x;
+		}
+
+		const_pointer address(const_reference x) const {
+			return &x;
+		}
+
+		pointer allocate(size_type n, const void *hint ATTRIBUTE_UNUSED = NULLPTR) {
+			UNUSED(hint);
+			if(n == 1) {
+				return static_cast<pointer>(pool_allocate(sizeof(T)));
+			}
+			return static_cast<pointer>(::operator new(n * sizeof(T)));
+		}
+
+		void deallocate(pointer p, size_type n) {
+			if(n == 1) {
+				pool_deallocate(p, sizeof(T));
+				return;
+			}
+			::operator delete(p);
+		}
+
+		size_type max_size() const {
+			return std::numeric_limits<size_type>::max() / sizeof(T);
+		}
+
+		void construct(pointer p, const T& val) {
+			new(static_cast<void *>(p)) T(val);
+		}
+
+		void destroy(pointer p) {
+			p->~T();
+		}
+};
+
+template<typename T, typename U> inline static bool operator==(const PoolAllocator<T>& a ATTRIBUTE_UNUSED, const PoolAllocator<U>& b ATTRIBUTE_UNUSED) {
+	UNUSED(a);
+	UNUSED(b);
+	return true;
+}
+
+template<typename T, typename U> inline static bool operator!=(const PoolAllocator<T>& a ATTRIBUTE_UNUSED, const PoolAllocator<U>& b ATTRIBUTE_UNUSED) {
+	UNUSED(a);
+	UNUSED(b);
+	return false;
+}
+
+}  // namespace eix
+
+#endif  // SRC_EIXTK_POOL_H_
@@ -11,6 +11,9 @@
 #define SRC_EIXTK_PTR_LIST_H_ 1
 
 #include <list>
+#include <vector>
+
+#include "eixTk/pool.h"
 
 namespace eix {
 template<typename m_Iterator> inline static void delete_all(m_Iterator b, m_Iterator e);
@@ -42,23 +45,52 @@ template<typename base_iterator> class ptr_iterator : public base_iterator {
 	};
 
 /// A list that only stores pointers to type.
-template<typename type> class ptr_list : public std::list<type*> {
+/// The list nodes are taken from the pool.
+template<typename type> class ptr_list : public std::list<type*, PoolAllocator<type*> > {
+	public:
+		typedef std::list<type*, PoolAllocator<type*> > base_list;
+		using base_list::begin;
+		using base_list::end;
+		using base_list::clear;
+
+		/// Normal access iterator.
+		typedef ptr_iterator<typename base_list::iterator> iterator;
+
+		/// Constant access iterator.
+		typedef ptr_iterator<typename base_list::const_iterator> const_iterator;
+
+		/// Reverse access iterator.
+		typedef ptr_iterator<typename base_list::reverse_iterator> reverse_iterator;
+
+		/// Constant reverse access iterator.
+		typedef ptr_iterator<typename base_list::const_reverse_iterator> const_reverse_iterator;
+
+		void delete_and_clear() {
+			delete_all(begin(), end());
+			clear();
+		}
+	};
+
+/// A vector that only stores pointers to type.
+/// In contrast to ptr_list, it allows binary search.
+template<typename type> class ptr_vector : public std::vector<type*> {
 	public:
-		using std::list<type*>::begin;
-		using std::list<type*>::end;
-		using std::list<type*>::clear;
+		typedef std::vector<type*> base_vector;
+		using base_vector::begin;
+		using base_vector::end;
+		using base_vector::clear;
 
 		/// Normal access iterator.
-		typedef ptr_iterator<typename std::list<type*>::iterator> iterator;
+		typedef ptr_iterator<typename base_vector::iterator> iterator;
 
 		/// Constant access iterator.
-		typedef ptr_iterator<typename std::list<type*>::const_iterator> const_iterator;
+		typedef ptr_iterator<typename base_vector::const_iterator> const_iterator;
 
 		/// Reverse access iterator.
-		typedef ptr_iterator<typename std::list<type*>::reverse_iterator> reverse_iterator;
+		typedef ptr_iterator<typename base_vector::reverse_iterator> reverse_iterator;
 
 		/// Constant reverse access iterator.
-		typedef ptr_iterator<typename std::list<type*>::const_reverse_iterator> const_reverse_iterator;
+		typedef ptr_iterator<typename base_vector::const_reverse_iterator> const_reverse_iterator;
 
 		void delete_and_clear() {
 			delete_all(begin(), end());
@@ -32,6 +32,7 @@
 #include "eixTk/null.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
+#include "eixTk/threads.h"
 
 using std::string;
 using std::vector;
@@ -218,7 +219,7 @@ GCC_DIAG_ON(sign-conversion)
 }
 
 char **ExplodeAtom::split(const char *str) {
-	static char* out[2] = { NULLPTR, NULLPTR };
+	static THREAD_LOCAL char* out[2] = { NULLPTR, NULLPTR };
 	const char *x(get_start_of_version(str, false));
 
 	if(unlikely(x == NULLPTR))
@@ -448,6 +449,27 @@ void StringHash::hash_string(const string& s) {
 	}
 }
 
+void StringHash::hash_merge(const StringHash& s) {
+	if(finalized || s.finalized) {
+		cerr << _("internal error: Hashing required after finalizing") << endl;
+		exit(EXIT_FAILURE);
+	}
+	if(!(hashing && s.hashing)) {
+		cerr << _("internal error: Hashing required in non-hash mode") << endl;
+		exit(EXIT_FAILURE);
+	}
+	// The frequency counter is 0 for the first occurrence, see hash_string()
+	for(StrSizeMap::const_iterator it(s.str_map.begin());
+		likely(it != s.str_map.end()); ++it) {
+		StrSizeMap::iterator i(str_map.find(it->first));
+		if(i != str_map.end()) {
+			i->second += it->second + 1;
+		} else {
+			str_map[it->first] = it->second;
+		}
+	}
+}
+
 void StringHash::store_words(const WordVec& v) {
 	for(WordVec::const_iterator i(v.begin()); likely(i != v.end()); ++i) {
 		store_string(*i);
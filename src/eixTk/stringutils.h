@@ -69,7 +69,7 @@ class ExplodeAtom {
 		static char *split_name(const char* str) ATTRIBUTE_NONNULL_;
 
 		/** Get name and version from a Atom (e.g. foobar and 1.2.3 from foobar-1.2.3).
-		 * @warn You'll get a pointer to a static array of 2 pointer to char. */
+		 * @warn You'll get a pointer to a static (thread-local) array of 2 pointer to char. */
 		static char **split(const char* str) ATTRIBUTE_NONNULL_;
 };
 
@@ -329,6 +329,9 @@ class StringHash : public WordVec {
 			hash_words(split_string(s));
 		}
 
+		/// Add the frequencies hashed by another (not finalized) StringHash
+		void hash_merge(const StringHash& s);
+
 		StringHash::size_type get_index(const std::string& s) const;
 
 		void output() const;
@@ -0,0 +1,77 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#include <config.h>
+
+#include <unistd.h>
+
+#ifdef WITH_THREADS
+#include <pthread.h>
+#endif
+
+#include <vector>
+
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+#include "eixTk/threads.h"
+
+using std::vector;
+
+namespace eix {
+
+#ifdef WITH_THREADS
+class ThreadCall {
+	public:
+		void (*func)(void *data);
+		void *data;
+};
+
+extern "C" {
+static void *thread_start(void *call);
+}
+
+static void *thread_start(void *call) {
+	ThreadCall *c(static_cast<ThreadCall *>(call));
+	(*(c->func))(c->data);
+	return NULLPTR;
+}
+#endif
+
+void run_parallel(unsigned int jobs, void (*func)(void *data), void *data) {
+#ifdef WITH_THREADS
+	ThreadCall call;
+	call.func = func;
+	call.data = data;
+	vector<pthread_t> threads;
+	for(; jobs > 1; --jobs) {
+		pthread_t thread;
+		if(unlikely(pthread_create(&thread, NULLPTR, thread_start, &call) != 0)) {
+			break;
+		}
+		threads.push_back(thread);
+	}
+	(*func)(data);
+	for(vector<pthread_t>::iterator it(threads.begin());
+		likely(it != threads.end()); ++it) {
+		pthread_join(*it, NULLPTR);
+	}
+#else
+	(*func)(data);
+#endif
+}
+
+unsigned int available_processors() {
+#ifdef _SC_NPROCESSORS_ONLN
+	long n(sysconf(_SC_NPROCESSORS_ONLN));
+	if(likely(n > 0)) {
+		return static_cast<unsigned int>(n);
+	}
+#endif
+	return 1;
+}
+
+}  // namespace eix
@@ -0,0 +1,93 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#ifndef SRC_EIXTK_THREADS_H_
+#define SRC_EIXTK_THREADS_H_ 1
+
+#ifdef WITH_THREADS
+#include <pthread.h>
+#endif
+
+#include "eixTk/null.h"
+
+#ifdef WITH_THREADS
+#define THREAD_LOCAL __thread
+#else
+#define THREAD_LOCAL
+#endif
+
+namespace eix {
+
+/** A mutex which is a dummy if compiled without thread support */
+class Mutex {
+	private:
+#ifdef WITH_THREADS
+		pthread_mutex_t m_mutex;
+#endif
+
+		// Not copyable
+		Mutex(const Mutex&);
+		Mutex& operator=(const Mutex&);
+
+	public:
+		Mutex() {
+#ifdef WITH_THREADS
+			pthread_mutex_init(&m_mutex, NULLPTR);
+#endif
+		}
+
+		~Mutex() {
+#ifdef WITH_THREADS
+			pthread_mutex_destroy(&m_mutex);
+#endif
+		}
+
+		void lock() {
+#ifdef WITH_THREADS
+			pthread_mutex_lock(&m_mutex);
+#endif
+		}
+
+		void unlock() {
+#ifdef WITH_THREADS
+			pthread_mutex_unlock(&m_mutex);
+#endif
+		}
+};
+
+/** Lock a mutex for the lifetime of this object */
+class MutexLocker {
+	private:
+		Mutex *m_mutex;
+
+		// Not copyable
+		MutexLocker(const MutexLocker&);
+		MutexLocker& operator=(const MutexLocker&);
+
+	public:
+		explicit MutexLocker(Mutex *mutex) ATTRIBUTE_NONNULL_ : m_mutex(mutex) {
+			m_mutex->lock();
+		}
+
+		~MutexLocker() {
+			m_mutex->unlock();
+		}
+};
+
+/** Call func(data) in jobs parallel threads (one of them is the calling
+    thread) and wait until all calls have returned.
+    If thread support is missing or some threads cannot be created,
+    func(data) is called less often, but at least once.
+    Hence, func should fetch its work from a queue until this is empty. */
+void run_parallel(unsigned int jobs, void (*func)(void *data), void *data);
+
+/** @return the number of online processors (at least 1) */
+unsigned int available_processors();
+
+}  // namespace eix
+
+#endif  // SRC_EIXTK_THREADS_H_
@@ -82,6 +82,12 @@ class VarsReader {
 			vars = vars_map;
 		}
 
+		/** Change the flags to read another file with the same instance.
+		    The flag INTO_MAP must remain unchanged. */
+		void setFlags(Flags flags) {
+			parse_flags = flags;
+		}
+
 		/** Prefix (path resp. varname) used for sourcing */
 		void setPrefix(const std::string& prefix) {
 			source_prefix = prefix;
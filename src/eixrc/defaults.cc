@@ -174,6 +174,12 @@ AddOption(STRING, "EIX_PREVIOUS",
 	"%{EPREFIX}" EIX_PREVIOUS, _(
 	"This file is the previous eix cache (used by eix-diff and eix-sync)."));
 
+AddOption(STRING, "VARDB_INDEX",
+	"%{EIX_CACHEFILE}.vardb", _(
+	"This file is the index of the installed packages which is written by\n"
+	"eix-update (if UPDATE_VARDB_INDEX is true) and used by eix and eix-diff.\n"
+	"If the string is empty, the index is not used."));
+
 AddOption(STRING, "EIX_REMOTE1",
 	"%{EPREFIX}" EIX_REMOTECACHEFILE1, _(
 	"This is the eix cache used when -R is in effect. If the string is nonempty,\n"
@@ -206,6 +212,11 @@ AddOption(STRING, "EBUILD_DEPEND_TEMP",
 	"%{EPREFIX_PORTAGE_EXEC}/var/cache/edb/dep/aux_db_key_temp", _(
 	"The path to the tempfile generated by \"ebuild depend\"."));
 
+AddOption(INTEGER, "EBUILD_TIMEOUT",
+	"0", _(
+	"If positive, an ebuild executed by the cache methods ebuild and ebuild*\n"
+	"is killed if it does not finish within this number of seconds."));
+
 AddOption(STRING, "EIX_WORLD",
 	"%{EPREFIX_ROOT}/var/lib/portage/world", _(
 	"This file is considered as the world file."));
@@ -450,6 +461,48 @@ AddOption(BOOLEAN, "UPDATE_VERBOSE",
 	"false", _(
 	"Whether eix-update -v is on by default (output cache method per ebuild)"));
 
+AddOption(INTEGER, "UPDATE_JOBS",
+	"0", _(
+	"The number of threads eix-update uses to read categories in parallel\n"
+	"(if the cache method supports it) and to calculate masks and hash tables.\n"
+	"It is also the number of ebuilds executed concurrently by cache method ebuild*.\n"
+	"0 means the number of processors."));
+
+AddOption(INTEGER, "SEARCH_JOBS",
+	"0", _(
+	"The number of threads eix uses to read and test packages in parallel.\n"
+	"This is only used if the database has a category index and if no test\n"
+	"needs data about installed packages or about stability.\n"
+	"Independently of this, the files of the installed versions of the matches\n"
+	"are read in that many threads before the matches are printed.\n"
+	"0 means the number of processors."));
+
+AddOption(BOOLEAN, "UPDATE_CATEGORY_INDEX",
+	"true", _(
+	"If true, eix-update stores an index of the positions of all categories\n"
+	"and packages in the database. This allows eix to read only the relevant\n"
+	"parts of the database for queries with exact category or package names."));
+
+AddOption(BOOLEAN, "UPDATE_TRIGRAM_INDEX",
+	"true", _(
+	"If true (and UPDATE_CATEGORY_INDEX is true), eix-update stores an index\n"
+	"of all trigrams (three consecutive characters) of the names, descriptions,\n"
+	"and homepages of the packages in the database. This allows eix to read\n"
+	"only candidate packages for queries with substrings, regular expressions,\n"
+	"or patterns on these fields."));
+
+AddOption(BOOLEAN, "UPDATE_INCREMENTAL",
+	"false", _(
+	"If true, eix-update stores fingerprints of all categories in the database\n"
+	"and reuses unchanged categories from the previous database."));
+
+AddOption(BOOLEAN, "UPDATE_VARDB_INDEX",
+	"true", _(
+	"If true, eix-update writes VARDB_INDEX which contains the entries of the\n"
+	"category directories of /var/db/pkg and the files of the installed\n"
+	"versions which eix reads. Categories and versions whose directories\n"
+	"have changed since then are read from /var/db/pkg."));
+
 AddOption(STRING, "CACHE_METHOD_PARSE",
 	"#metadata-md5#metadata-flat#assign", _(
 	"This string is appended to all cache methods using parse[*] or ebuild[*]."));
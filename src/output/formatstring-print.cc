@@ -47,8 +47,6 @@ using std::string;
 using std::cerr;
 using std::endl;
 
-static Package *old_or_new(string *new_name, Package *older, Package *newer, const string& name) ATTRIBUTE_NONNULL_;
-
 class VersionVariables {
 	private:
 		const Version *m_version;
@@ -551,49 +549,115 @@ class Scanner {
 
 static Scanner *scanner = NULLPTR;
 
+/** A package property resolved by the scanner */
+class PkgProperty {
+	public:
+		/* The name for error messages */
+		string name;
+		Scanner::Prop t;
+		Scanner::Plain plain;
+		Scanner::ColonVar colon_var;
+		Scanner::ColonOther colon_other;
+		string after_colon;
+
+		/* false if the property is unknown; this is an error only if used */
+		bool known;
+
+		void init(const string& n);
+};
+
+/** All what is needed to print a property, resolved from its name once */
+class PropertyHandler {
+	public:
+		/* The property for get_package_property() */
+		PkgProperty pkg;
+
+		/* For get_diff_package_property(): Either diff is set, or the
+		   old/new prefix of the name is stripped for diff_pkg */
+		Scanner::Diff diff;
+		bool older;
+		PkgProperty diff_pkg;
+
+		void init(const string& name);
+};
+
+typedef map<string, PropertyHandler> PropertyHandlers;
+
+/* Equal names share the same handler; the addresses are stable */
+static PropertyHandlers *property_handlers = NULLPTR;
+
 void PrintFormat::init_static() {
 	eix_assert_static(scanner == NULLPTR);
 	scanner = new Scanner;
+	property_handlers = new PropertyHandlers;
 	AnsiColor::init_static();
 }
 
-void PrintFormat::get_pkg_property(OutputString *s, Package *package, const string& name) const {
-	eix_assert_static(scanner != NULLPTR);
-	Scanner::Prop t;
-	Scanner::Plain plain(scanner->get_plain(name, &t));
-	Scanner::ColonVar colon_var;
-	Scanner::ColonOther colon_other;
-	string after_colon;
-	if(plain == NULLPTR) {
-		string::size_type col(name.find(':'));
-		if(likely(col != string::npos)) {
-			// we misuse here "after_colon" to mean "before_colon"
-			after_colon.assign(name.substr(0, col));
-			colon_var = scanner->get_colon_var(after_colon, &t);
-			if(unlikely(colon_var == NULLPTR)) {
-				colon_other = scanner->get_colon_other(after_colon, &t);
-				if(unlikely(colon_other == NULLPTR)) {
-					// flag that we failed
-					col = string::npos;
-				}
-			}
-		}
-		if(unlikely(col == string::npos)) {
-			cerr << eix::format(_("unknown property %r")) % name << endl;
-			exit(EXIT_FAILURE);
+void PkgProperty::init(const string& n) {
+	name = n;
+	colon_var = NULLPTR;
+	colon_other = NULLPTR;
+	known = true;
+	plain = scanner->get_plain(name, &t);
+	if(plain != NULLPTR) {
+		return;
+	}
+	string::size_type col(name.find(':'));
+	if(likely(col != string::npos)) {
+		const string before_colon(name, 0, col);
+		colon_var = scanner->get_colon_var(before_colon, &t);
+		if(colon_var == NULLPTR) {
+			colon_other = scanner->get_colon_other(before_colon, &t);
+			known = (colon_other != NULLPTR);
 		}
 		after_colon.assign(name, col + 1, string::npos);
+	} else {
+		known = false;
 	}
-	if(unlikely((t == Scanner::VER) && (version_variables == NULLPTR))) {
-		cerr << eix::format(_("property %r used outside version context")) % name << endl;
+}
+
+void PropertyHandler::init(const string& name) {
+	pkg.init(name);
+	diff = scanner->get_diff(name);
+	older = false;
+	const char *s(name.c_str());
+	if(strncmp(s, "old", 3) == 0) {
+		older = true;
+		s += 3;
+	} else if(strncmp(s, "new", 3) == 0) {
+		s += 3;
+	}
+	diff_pkg.init(s);
+}
+
+void Property::compile() {
+	// Before PrintFormat::init_static() it is resolved when first printed
+	if(unlikely(property_handlers == NULLPTR)) {
+		return;
+	}
+	PropertyHandlers::iterator it(property_handlers->find(name));
+	if(it == property_handlers->end()) {
+		it = property_handlers->insert(it, PropertyHandlers::value_type(name, PropertyHandler()));
+		it->second.init(name);
+	}
+	handler = &(it->second);
+}
+
+void PrintFormat::get_pkg_property(OutputString *s, Package *package, const PkgProperty& property) const {
+	if(unlikely(!property.known)) {
+		cerr << eix::format(_("unknown property %r")) % property.name << endl;
 		exit(EXIT_FAILURE);
 	}
-	if(plain != NULLPTR) {
-		(this->*plain)(s, package);
+	if(unlikely((property.t == Scanner::VER) && (version_variables == NULLPTR))) {
+		cerr << eix::format(_("property %r used outside version context")) % property.name << endl;
+		exit(EXIT_FAILURE);
+	}
+	if(property.plain != NULLPTR) {
+		(this->*property.plain)(s, package);
 		return;
 	}
-	if(colon_var == NULLPTR) {
-		(this->*colon_other)(s, package, after_colon);
+	if(property.colon_var == NULLPTR) {
+		(this->*property.colon_other)(s, package, property.after_colon);
 		return;
 	}
 	// colon_var:
@@ -603,7 +667,7 @@ void PrintFormat::get_pkg_property(OutputString *s, Package *package, const stri
 	VersionVariables variables;
 	VersionVariables *previous_variables(version_variables);
 	version_variables = &variables;
-	(this->*colon_var)(package, after_colon);
+	(this->*property.colon_var)(package, property.after_colon);
 	version_variables = previous_variables;
 	s->assign(variables.result);
 }
@@ -1661,28 +1725,14 @@ void PrintFormat::VER_MASKREASONSS(OutputString *s, Package *package ATTRIBUTE_U
 	ver_maskreasons(s, maskreasonss_skip, maskreasonss_sep);
 }
 
-static Package *old_or_new(string *new_name, Package *older, Package *newer, const string& name) {
-	const char *s(name.c_str());
-	if(strncmp(s, "old", 3) == 0) {
-		*new_name = s + 3;
-		return older;
-	}
-	if(strncmp(s, "new", 3) == 0) {
-		*new_name = s + 3;
-		return newer;
-	}
-	*new_name = name;
-	return newer;
-}
-
-void get_package_property(OutputString *s, const PrintFormat *fmt, void *entity, const string& name) {
-	fmt->get_pkg_property(s, static_cast<Package *>(entity), name);
+void get_package_property(OutputString *s, const PrintFormat *fmt, void *entity, const PropertyHandler *property) {
+	fmt->get_pkg_property(s, static_cast<Package *>(entity), property->pkg);
 }
 
-void get_diff_package_property(OutputString *s, const PrintFormat *fmt, void *entity, const string& name) {
+void get_diff_package_property(OutputString *s, const PrintFormat *fmt, void *entity, const PropertyHandler *property) {
 	Package *older((static_cast<Package**>(entity))[0]);
 	Package *newer((static_cast<Package**>(entity))[1]);
-	Scanner::Diff diff(scanner->get_diff(name));
+	Scanner::Diff diff(property->diff);
 	if(unlikely(diff != Scanner::DIFF_NONE)) {
 		LocalCopy copynewer(fmt, newer);
 		LocalCopy copyolder(fmt, older);
@@ -1715,7 +1765,5 @@ void get_diff_package_property(OutputString *s, const PrintFormat *fmt, void *en
 		}
 		return;
 	}
-	string new_name;
-	Package *package(old_or_new(&new_name, older, newer, name));
-	fmt->get_pkg_property(s, package, new_name);
+	fmt->get_pkg_property(s, (property->older ? older : newer), property->diff_pkg);
 }
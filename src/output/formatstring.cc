@@ -352,11 +352,12 @@ bool PrintFormat::recPrint(OutputString *result, void *entity, GetProperty get_p
 			case Node::OUTPUT: {
 					Property *p(static_cast<Property*>(root));
 					OutputString *s;
+					OutputString value;
 					if(p->user_variable) {
 						s = &user_variables[p->name];
 					} else {
-						s = new OutputString();
-						get_property(s, this, entity, p->name);
+						s = &value;
+						get_property(s, this, entity, p->get_handler());
 					}
 					if(!s->empty()) {
 						printed = true;
@@ -373,13 +374,14 @@ bool PrintFormat::recPrint(OutputString *result, void *entity, GetProperty get_p
 			default: {
 					ConditionBlock *ief(static_cast<ConditionBlock*>(root));
 					OutputString *rhs;
+					OutputString rhs_value;
 					switch(ief->rhs) {
 						case ConditionBlock::RHS_VAR:
 							rhs = &(user_variables[ief->text.text.as_string()]);
 							break;
 						case ConditionBlock::RHS_PROPERTY:
-							rhs = new OutputString();
-							get_property(rhs, this, entity, ief->text.text.as_string());
+							rhs = &rhs_value;
+							get_property(rhs, this, entity, ief->rhs_property.get_handler());
 							break;
 						default:
 						// case ConditionBlock::RHS_STRING:
@@ -401,11 +403,12 @@ bool PrintFormat::recPrint(OutputString *result, void *entity, GetProperty get_p
 					}
 					// Node::IF:
 					OutputString *r;
+					OutputString value;
 					if(ief->user_variable) {
 						r = &(user_variables[ief->variable.name]);
 					} else {
-						r = new OutputString();
-						get_property(r, this, entity, ief->variable.name);
+						r = &value;
+						get_property(r, this, entity, ief->variable.get_handler());
 					}
 					bool ok(rhs->is_equal(*r));
 					if(ief->negation) {
@@ -548,8 +551,12 @@ FormatParser::ParserState FormatParser::state_PROPERTY() {
 	   With the currently available attribute this is not necessary.
 	*/
 GCC_DIAG_OFF(sign-conversion)
-	keller.push(new Property(string(band_position, q - band_position), user_variable));
+	Property *p(new Property(string(band_position, q - band_position), user_variable));
 GCC_DIAG_ON(sign-conversion)
+	if(!user_variable) {
+		p->compile();
+	}
+	keller.push(p);
 	band_position = q + 1;
 	return START;
 }
@@ -606,6 +613,9 @@ FormatParser::ParserState FormatParser::state_IF() {
 		return ERROR;
 	}
 	n->variable = Property(string(name_start, i));
+	if(!n->user_variable) {
+		n->variable.compile();
+	}
 
 	band_position = seek_character(band_position);
 	if(*band_position == '}') {
@@ -676,6 +686,10 @@ FormatParser::ParserState FormatParser::state_IF() {
 		}
 	}
 	n->text = Text(textbuffer);
+	if(n->rhs == ConditionBlock::RHS_PROPERTY) {
+		n->rhs_property = Property(textbuffer.as_string());
+		n->rhs_property.compile();
+	}
 
 	if(*band_position != '}') {
 		if(*band_position) {
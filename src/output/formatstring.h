@@ -17,6 +17,7 @@
 #include <string>
 #include <vector>
 
+#include "eixTk/likely.h"
 #include "eixTk/null.h"
 #include "eixTk/outputstring.h"
 #include "portage/extendedversion.h"
@@ -30,7 +31,9 @@ class KeywordsFlags;
 class Mask;
 class MaskFlags;
 class Package;
+class PkgProperty;
 class PortageSettings;
+class PropertyHandler;
 class VarDbPkg;
 class Version;
 template<typename m_Type> class MaskList;
@@ -67,13 +70,27 @@ class Property : public Node {
 		std::string name;
 		bool user_variable;
 
-		Property() : Node(OUTPUT), user_variable(false) {
+		/* The handler of the property which is looked up by name only once.
+		   It is NULLPTR for user variables or if not resolved yet. */
+		const PropertyHandler *handler;
+
+		Property() : Node(OUTPUT), user_variable(false), handler(NULLPTR) {
+		}
+
+		explicit Property(const std::string& n) : Node(OUTPUT), name(n), user_variable(false), handler(NULLPTR) {
 		}
 
-		explicit Property(const std::string& n) : Node(OUTPUT), name(n), user_variable(false) {
+		Property(const std::string& n, bool user_var) : Node(OUTPUT), name(n), user_variable(user_var), handler(NULLPTR) {
 		}
 
-		Property(const std::string& n, bool user_var) : Node(OUTPUT), name(n), user_variable(user_var) {
+		/* Resolve handler if this is possible already */
+		void compile();
+
+		const PropertyHandler *get_handler() {
+			if(unlikely(handler == NULLPTR)) {
+				compile();
+			}
+			return handler;
 		}
 };
 
@@ -83,6 +100,7 @@ class ConditionBlock : public Node {
 
 		Property variable;
 		Text     text;
+		Property rhs_property;
 		enum Rhs { RHS_STRING, RHS_PROPERTY, RHS_VAR } rhs;
 		Node     *if_true, *if_false;
 		bool user_variable, negation;
@@ -159,11 +177,11 @@ class VersionVariables;
 class PrintFormat {
 	friend class LocalCopy;
 	friend class Scanner;
-	friend void get_package_property(OutputString *s, const PrintFormat *fmt, void *entity, const std::string& name) ATTRIBUTE_NONNULL_;
-	friend void get_diff_package_property(OutputString *s, const PrintFormat *fmt, void *void_entity, const std::string& name) ATTRIBUTE_NONNULL_;
+	friend void get_package_property(OutputString *s, const PrintFormat *fmt, void *entity, const PropertyHandler *property) ATTRIBUTE_NONNULL_;
+	friend void get_diff_package_property(OutputString *s, const PrintFormat *fmt, void *void_entity, const PropertyHandler *property) ATTRIBUTE_NONNULL_;
 
 	public:
-		typedef void (*GetProperty)(OutputString *s, const PrintFormat *fmt, void *entity, const std::string& property) ATTRIBUTE_NONNULL_;
+		typedef void (*GetProperty)(OutputString *s, const PrintFormat *fmt, void *entity, const PropertyHandler *property) ATTRIBUTE_NONNULL_;
 		typedef std::vector<ExtendedVersion::Overlay> OverlayTranslations;
 		typedef std::vector<bool> OverlayUsed;
 
@@ -210,7 +228,7 @@ class PrintFormat {
 		void get_installed(Package *package, Node *root) const ATTRIBUTE_NONNULL((2));
 		void get_versions_versorted(Package *package, Node *root, PrintFormat::VerVec *versions) const ATTRIBUTE_NONNULL((2));
 		void get_versions_slotsorted(Package *package, Node *root, PrintFormat::VerVec *versions) const ATTRIBUTE_NONNULL((2));
-		void get_pkg_property(OutputString *s, Package *package, const std::string& name) const ATTRIBUTE_NONNULL_;
+		void get_pkg_property(OutputString *s, Package *package, const PkgProperty& property) const ATTRIBUTE_NONNULL_;
 
 		// It follows a list of indirect functions called in get_pkg_property():
 		// Functions with capital letters are parser destinations; other functions
@@ -143,6 +143,12 @@ string BasicVersion::getRevision() const {
 }
 
 BasicVersion::ParseResult BasicVersion::parseVersion(const string& str, string *errtext, eix::SignedBool accept_garbage) {
+	ParseResult r(parse_parts(str, errtext, accept_garbage));
+	calc_sortkey();
+	return r;
+}
+
+BasicVersion::ParseResult BasicVersion::parse_parts(const string& str, string *errtext, eix::SignedBool accept_garbage) {
 	m_parts.clear();
 	string::size_type pos(0);
 	string::size_type len(str.find_first_not_of("0123456789", pos));
@@ -263,7 +269,99 @@ BasicVersion::ParseResult BasicVersion::parseVersion(const string& str, string *
 	return parsedGarbage;
 }
 
+/** Append a number (which may have leading zeros) to a sort key such that
+    the bytewise order of the keys is the numerical order.
+    @return false if the number is too long */
+static bool append_number(string *key, const string& num) {
+	string::size_type start(num.find_first_not_of('0'));
+	if(start == string::npos) {
+		key->append(1, '\0');
+		return true;
+	}
+	string::size_type len(num.size() - start);
+	if(unlikely(len > 0xFF)) {
+		return false;
+	}
+	key->append(1, static_cast<char>(len));
+	key->append(num, start, len);
+	return true;
+}
+
+/** The sort key is the concatenation of the parts. Each part starts with
+    2 * parttype + 2, and the key ends with 2 * revision + 1: A missing part
+    is larger than a suffix like _alpha but smaller than a revision.
+    After the type follows the content, encoded so that it cannot be the
+    prefix of a different content of the same type:
+    - The first part and the numbers of suffixes and revisions are numbers.
+    - A primary part without a leading zero is 1 followed by the number.
+      Otherwise, the trailing zeros are stripped and the remaining string
+      is compared; it is stored as 0, the string, and a terminating 0.
+    - A character is the character. */
+void BasicVersion::calc_sortkey() {
+	m_sortkey.clear();
+	m_sortkey_tilde = string::npos;
+	for(PartsType::const_iterator it(m_parts.begin());
+		likely(it != m_parts.end()); ++it) {
+		const string& content(it->partcontent);
+		if(it->parttype == BasicPart::revision) {
+			m_sortkey_tilde = m_sortkey.size();
+		}
+		m_sortkey.append(1, static_cast<char>(2 * it->parttype + 2));
+		switch(it->parttype) {
+			case BasicPart::garbage:
+				// garbage has no consistent order
+				m_sortkey.clear();
+				return;
+			case BasicPart::character:
+				if(unlikely(content.size() != 1)) {
+					m_sortkey.clear();
+					return;
+				}
+				m_sortkey.append(content);
+				break;
+			case BasicPart::primary:
+				if(content.empty() || (content[0] == '0')) {
+					string::size_type len(content.find_last_not_of('0'));
+					m_sortkey.append(1, '\0');
+					if(len != string::npos) {
+						m_sortkey.append(content, 0, len + 1);
+					}
+					m_sortkey.append(1, '\0');
+					break;
+				}
+				m_sortkey.append(1, '\1');
+				// fallthrough
+			default:
+				if(unlikely(!append_number(&m_sortkey, content))) {
+					m_sortkey.clear();
+					return;
+				}
+				break;
+		}
+	}
+	if(m_sortkey_tilde == string::npos) {
+		m_sortkey_tilde = m_sortkey.size();
+	}
+	m_sortkey.append(1, static_cast<char>(2 * BasicPart::revision + 1));
+}
+
 eix::SignedBool BasicVersion::compare(const BasicVersion& left, const BasicVersion& right) {
+	if(likely(!left.m_sortkey.empty() && !right.m_sortkey.empty())) {
+		return eix::toSignedBool(left.m_sortkey.compare(right.m_sortkey));
+	}
+	return compare_parts(left, right);
+}
+
+eix::SignedBool BasicVersion::compareTilde(const BasicVersion& left, const BasicVersion& right) {
+	if(likely(!left.m_sortkey.empty() && !right.m_sortkey.empty())) {
+		// Here, a missing part is smaller than everything
+		return eix::toSignedBool(left.m_sortkey.compare(0, left.m_sortkey_tilde,
+			right.m_sortkey, 0, right.m_sortkey_tilde));
+	}
+	return compareTilde_parts(left, right);
+}
+
+eix::SignedBool BasicVersion::compare_parts(const BasicVersion& left, const BasicVersion& right) {
 	PartsType::const_iterator
 		it_left(left.m_parts.begin()),
 		it_right(right.m_parts.begin());
@@ -288,7 +386,7 @@ eix::SignedBool BasicVersion::compare(const BasicVersion& left, const BasicVersi
 	return 0;
 }
 
-eix::SignedBool BasicVersion::compareTilde(const BasicVersion& left, const BasicVersion& right) {
+eix::SignedBool BasicVersion::compareTilde_parts(const BasicVersion& left, const BasicVersion& right) {
 	for(PartsType::const_iterator it_left(left.m_parts.begin()),
 		it_right(right.m_parts.begin()); ; ++it_left, ++it_right) {
 		bool right_end((it_right == right.m_parts.end())
@@ -10,8 +10,8 @@
 #ifndef SRC_PORTAGE_BASICVERSION_H_
 #define SRC_PORTAGE_BASICVERSION_H_ 1
 
-#include <list>
 #include <string>
+#include <vector>
 
 #include "eixTk/constexpr.h"
 #include "eixTk/eixint.h"
@@ -78,6 +78,9 @@ class BasicVersion {
 			parsedGarbage
 		};
 
+		BasicVersion() : m_sortkey_tilde(0) {
+		}
+
 		virtual ~BasicVersion() { }
 
 		/// Parse the version-string pointed to by str.
@@ -100,8 +103,24 @@ class BasicVersion {
 
 	protected:
 		/// Splitted m_primsplit-version.
-		typedef std::list<BasicPart> PartsType;
+		typedef std::vector<BasicPart> PartsType;
 		PartsType m_parts;
+
+		/// A string whose bytewise order is the order of the versions;
+		/// it is empty if this cannot be expressed (e.g. for garbage).
+		/// This must be recalculated by calc_sortkey() when m_parts changes.
+		std::string m_sortkey;
+
+		/// The length of the part of m_sortkey before the revision
+		std::string::size_type m_sortkey_tilde;
+
+		void calc_sortkey();
+
+	private:
+		BasicVersion::ParseResult parse_parts(const std::string& str, std::string *errtext, eix::SignedBool accept_garbage);
+
+		static eix::SignedBool compare_parts(const BasicVersion& left, const BasicVersion& right) ATTRIBUTE_PURE;
+		static eix::SignedBool compareTilde_parts(const BasicVersion& left, const BasicVersion& right) ATTRIBUTE_PURE;
 };
 
 
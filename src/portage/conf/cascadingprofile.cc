@@ -188,9 +188,26 @@ bool CascadingProfile::readremoveFiles() {
 	return ret;
 }
 
+void CascadingProfile::add_fingerprint(const string& filename, const char *repo, bool only_repo, const LineVec& lines) {
+	m_fingerprint.add(filename);
+	m_fingerprint.add((repo == NULLPTR) ? "" : repo);
+	m_fingerprint.add(static_cast<uint64_t>(only_repo ? 1 : 0));
+	m_fingerprint.add(lines.size());
+	for(LineVec::const_iterator it(lines.begin()); likely(it != lines.end()); ++it) {
+		m_fingerprint.add(*it);
+	}
+}
+
+void CascadingProfile::add_fingerprint(const string& filename) {
+	LineVec lines;
+	pushback_lines(filename.c_str(), &lines, true, true);
+	add_fingerprint(filename, NULLPTR, false, lines);
+}
+
 bool CascadingProfile::readPackages(const string& filename, const char *repo, bool only_repo) {
 	LineVec lines;
 	pushback_lines(filename.c_str(), &lines, true, true);
+	add_fingerprint(filename, repo, only_repo, lines);
 	bool ret(false);
 	PreList::FilenameIndex file_system(p_system.push_name(filename, repo, only_repo));
 	PreList::FilenameIndex file_profile(p_profile.push_name(filename, repo, only_repo));
@@ -225,24 +242,28 @@ bool CascadingProfile::readPackages(const string& filename, const char *repo, bo
 bool CascadingProfile::readPackageMasks(const string& filename, const char *repo, bool only_repo) {
 	LineVec lines;
 	pushback_lines(filename.c_str(), &lines, true, true, -1);
+	add_fingerprint(filename, repo, only_repo, lines);
 	return p_package_masks.handle_file(lines, filename, repo, false, true, only_repo);
 }
 
 bool CascadingProfile::readPackageUnmasks(const string& filename, const char *repo, bool only_repo) {
 	LineVec lines;
 	pushback_lines(filename.c_str(), &lines, true, true);
+	add_fingerprint(filename, repo, only_repo, lines);
 	return p_package_unmasks.handle_file(lines, filename, repo, false, false, only_repo);
 }
 
 bool CascadingProfile::readPackageKeywords(const string& filename, const char *repo, bool only_repo) {
 	LineVec lines;
 	pushback_lines(filename.c_str(), &lines, true, true);
+	add_fingerprint(filename, repo, only_repo, lines);
 	return p_package_keywords.handle_file(lines, filename, repo, false, false, only_repo);
 }
 
 bool CascadingProfile::readPackageAcceptKeywords(const string& filename, const char *repo, bool only_repo) {
 	LineVec lines;
 	pushback_lines(filename.c_str(), &lines, true, true);
+	add_fingerprint(filename, repo, only_repo, lines);
 	return p_package_accept_keywords.handle_file(lines, filename, repo, true, false, only_repo);
 }
 
@@ -13,6 +13,7 @@
 #include <string>
 #include <vector>
 
+#include "eixTk/digest.h"
 #include "eixTk/null.h"
 #include "eixTk/stringtypes.h"
 #include "portage/mask.h"
@@ -74,8 +75,12 @@ class CascadingProfile {
 		MaskList<KeywordMask> m_package_accept_keywords;/**< Masks from package.accept_keywords */
 		PreList p_system, p_profile, p_package_masks, p_package_unmasks,
 			p_package_keywords, p_package_accept_keywords;
+		Digest m_fingerprint;            /**< Of the content of all files read */
 
 	private:
+		/** Feed a file which has been read into m_fingerprint */
+		void add_fingerprint(const std::string& filename, const char *repo, bool only_repo, const LineVec& lines);
+
 		/** Add all files from profile and its parents to m_profile_files. */
 		bool addProfile(const char *profile, WordSet *sourced_files) ATTRIBUTE_NONNULL((2));
 		bool addProfile(const char *profile) ATTRIBUTE_NONNULL_ {
@@ -145,6 +150,16 @@ class CascadingProfile {
 			m_profile_files.clear();
 		}
 
+		/** Feed the content of a file which is read elsewhere (like the
+		    world file) into the fingerprint. */
+		void add_fingerprint(const std::string& filename);
+
+		/** @return a fingerprint of the content of all files read so far.
+		    If it is unchanged, applyMasks() gives the same results. */
+		std::string fingerprint() const {
+			return m_fingerprint.get();
+		}
+
 		void applyMasks(Package *p) const ATTRIBUTE_NONNULL_;
 		void applyKeywords(Package *p) const ATTRIBUTE_NONNULL_;
 
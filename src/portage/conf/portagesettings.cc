@@ -324,6 +324,7 @@ void PortageSettings::init(EixRc *eixrc, bool getlocal, bool init_world, bool pr
 		if(profile->m_world.add_file((*eixrc)["EIX_WORLD"].c_str(), Mask::maskInWorld, false)) {
 			profile->use_world = true;
 		}
+		profile->add_fingerprint((*eixrc)["EIX_WORLD"]);
 		profile->m_world.finalize();
 		read_world_sets((*eixrc)["EIX_WORLD_SETS"].c_str());
 	}
@@ -397,7 +398,10 @@ void PortageSettings::init(EixRc *eixrc, bool getlocal, bool init_world, bool pr
 		}
 	} else {
 		m_local_arch_set = m_auto_arch_set = &m_arch_set;
-	} {
+	}
+	m_accepted_keywords_flags.init(m_accepted_keywords_set);
+	m_auto_arch_flags.init(*m_auto_arch_set);
+	{
 		// Calculate m_raised_arch by prepending ~ to every token
 		WordSet archset;
 		for(WordSet::const_iterator it(m_arch_set.begin());
@@ -1049,7 +1053,7 @@ bool PortageUserConfig::setKeyflags(Package *p, Keywords::Redundant check) const
 		}
 		if(kv.size() == kvsize) {
 			// Nothing has changed. In this case, we take defaults:
-			kf.set_keyflags(it->get_keyflags(m_settings->m_accepted_keywords_set));
+			kf.set_keyflags(it->get_keyflags(m_settings->m_accepted_keywords_flags));
 			it->keyflags = kf;
 			it->save_keyflags(Version::SAVEKEY_ACCEPT);
 		} else {
@@ -1230,14 +1234,14 @@ void PortageUserConfig::pushback_set_accepted_keywords(WordVec *result, const Ve
 
 /// Set stability according to arch or local ACCEPT_KEYWORDS
 void PortageSettings::setKeyflags(Package *p, bool use_accepted_keywords) const {
-	const WordSet *accept_set;
+	const AcceptedKeywords *accept_set;
 	Version::SavedKeyIndex ind;
 	if(use_accepted_keywords) {
 		ind = Version::SAVEKEY_ACCEPT;
-		accept_set = &m_accepted_keywords_set;
+		accept_set = &m_accepted_keywords_flags;
 	} else {
 		ind = Version::SAVEKEY_ARCH;
-		accept_set = m_auto_arch_set;
+		accept_set = &m_auto_arch_flags;
 	}
 	if(p->restore_keyflags(ind))
 		return;
@@ -1333,6 +1337,10 @@ void PortageSettings::setMasks(Package *p, bool filemask_is_profile) const {
 	p->save_maskflags(Version::SAVEMASK_PROFILE);
 }
 
+string PortageSettings::profile_fingerprint() const {
+	return profile->fingerprint();
+}
+
 void PortageSettings::calc_local_sets(Package *p) const {
 	m_package_sets.applyListItems(p);
 	if(m_recurse_sets) {
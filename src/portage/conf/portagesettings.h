@@ -145,6 +145,8 @@ class PortageSettings : public std::map<std::string, std::string> {
 		WordSet                  m_accepted_keywords_set, m_arch_set,
 		                         m_plain_accepted_keywords_set,
 		                        *m_local_arch_set, *m_auto_arch_set;
+		/** m_accepted_keywords_set and *m_auto_arch_set for get_keyflags() */
+		AcceptedKeywords         m_accepted_keywords_flags, m_auto_arch_flags;
 		std::string              m_raised_arch;
 
 		MaskList<SetMask>        m_package_sets;
@@ -255,6 +257,9 @@ class PortageSettings : public std::map<std::string, std::string> {
 			return &world_sets;
 		}
 
+		/** @return the fingerprint of the profile without local settings */
+		std::string profile_fingerprint() const;
+
 		/** pushback categories from profiles to vec. Categories may be duplicate.
 		    Result is not cashed, i.e. this should be called only once. */
 		void pushback_categories(WordVec *vec) ATTRIBUTE_NONNULL_;
@@ -278,6 +283,16 @@ class PortageSettings : public std::map<std::string, std::string> {
 			p->finalize_masks();
 		}
 
+		/** Calculate the list of world sets which calc_world_sets() and
+		    thus finalize() and setMasks() would otherwise calculate lazily.
+		    Afterwards, finalize() and setMasks() can be called in parallel
+		    threads as long as each thread handles other packages. */
+		void prepare_world_sets() {
+			if(!world_setslist_up_to_date) {
+				update_world_setslist();
+			}
+		}
+
 		void get_effective_keywords_profile(Package *p) const ATTRIBUTE_NONNULL_;
 
 		void get_effective_keywords_userprofile(Package *p) const ATTRIBUTE_NONNULL_;
@@ -9,6 +9,8 @@
 
 #include <config.h>
 
+#include <cstring>
+
 #include <algorithm>
 #include <string>
 
@@ -44,78 +46,110 @@ const KeywordsFlags::KeyType
 	KeywordsFlags::KEY_SOMEUNSTABLE,
 	KeywordsFlags::KEY_TILDESTARMATCH;
 
-inline static bool is_not_testing(const string& s);
-inline static bool is_testing(const string& s);
+void AcceptedKeywords::init(const WordSet& accepted_keywords) {
+	m_words.assign(accepted_keywords.begin(), accepted_keywords.end());
+	some_not_testing = some_testing = false;
+	for(WordVec::const_iterator it(m_words.begin());
+		likely(it != m_words.end()); ++it) {
+		char c((*it)[0]);
+		if(c == '~') {
+			some_testing = true;
+		} else if(c != '-') {
+			some_not_testing = true;
+		}
+	}
+	double_asterisk = (accepted_keywords.count("**") != 0);
+	asterisk = (accepted_keywords.count("*") != 0);
+	tilde_asterisk = (accepted_keywords.count("~*") != 0);
+}
 
-inline static bool is_not_testing(const string& s) {
-	char c(s[0]);
-	return ((c != '~') && (c != '-'));
+bool AcceptedKeywords::accepts(const char *s, string::size_type len) const {
+	for(WordVec::const_iterator it(m_words.begin());
+		likely(it != m_words.end()); ++it) {
+		if((it->size() == len) && (it->compare(0, len, s, len) == 0)) {
+			return true;
+		}
+	}
+	return false;
 }
 
-inline static bool is_testing(const string& s) {
-	return (s[0] == '~');
+/** Compare the keyword s of length len with a 0-terminated literal */
+inline static bool is_keyword(const char *s, string::size_type len, const char *literal) ATTRIBUTE_NONNULL_ ATTRIBUTE_PURE;
+inline static bool is_keyword(const char *s, string::size_type len, const char *literal) {
+	return ((strncmp(s, literal, len) == 0) && (literal[len] == '\0'));
 }
 
-KeywordsFlags::KeyType KeywordsFlags::get_keyflags(const WordSet& accepted_keywords, const string& keywords) {
-	KeyType m(KEY_EMPTY);
-	WordSet keywords_set;
-	make_set<string>(&keywords_set, split_string(keywords));
-	for(WordSet::const_iterator it(keywords_set.begin());
-		likely(it != keywords_set.end()); ++it) {
-		if((*it)[0] == '-') {
-			if(*it == "-*") {
-				m |= KEY_MINUSASTERISK;
-			} else if(*it == "-~*") {
-				m |= KEY_MINUSUNSTABLE;
-			} else if(accepted_keywords.find(it->substr(1)) != accepted_keywords.end()) {
-				m |= KEY_MINUSKEYWORD;
-			}
-			continue;
+/** @return the flags caused by the single keyword s of length len */
+inline static KeywordsFlags::KeyType keyword_flags(const AcceptedKeywords& accepted, const char *s, string::size_type len) ATTRIBUTE_NONNULL_;
+inline static KeywordsFlags::KeyType keyword_flags(const AcceptedKeywords& accepted, const char *s, string::size_type len) {
+	if(*s == '-') {
+		if(is_keyword(s, len, "-*")) {
+			return KeywordsFlags::KEY_MINUSASTERISK;
 		}
-		if(*it == "*") {
-			m |= KEY_SOMESTABLE;
-			if(find_if(accepted_keywords.begin(), accepted_keywords.end(), is_not_testing)
-				!= accepted_keywords.end()) {
-				m |= KEY_STABLE;
-			}
-			continue;
+		if(is_keyword(s, len, "-~*")) {
+			return KeywordsFlags::KEY_MINUSUNSTABLE;
 		}
-		bool found(false);
-		if(accepted_keywords.find(*it) != accepted_keywords.end()) {
-			found = true;
-			m |= (KEY_STABLE | KEY_SOMESTABLE);
+		if(accepted.accepts(s + 1, len - 1)) {
+			return KeywordsFlags::KEY_MINUSKEYWORD;
 		}
-		if((*it)[0] == '~') {
-			if(found) {
-				m |= KEY_ARCHUNSTABLE;
-			} else if(*it == "~*") {
-				m |= KEY_SOMEUNSTABLE;
-				if(find_if(accepted_keywords.begin(), accepted_keywords.end(), is_testing)
-					!= accepted_keywords.end()) {
-					m |= KEY_STABLE;
-				}
-			} else if(accepted_keywords.find(it->substr(1)) != accepted_keywords.end()) {
-				m |= KEY_ARCHUNSTABLE;
-			} else {
-				m |= KEY_ALIENUNSTABLE;
-			}
-		} else if((*it)[0] != '-') {
-			m |= (found ? KEY_ARCHSTABLE : KEY_ALIENSTABLE);
+		return KeywordsFlags::KEY_EMPTY;
+	}
+	if(is_keyword(s, len, "*")) {
+		if(accepted.some_not_testing) {
+			return (KeywordsFlags::KEY_SOMESTABLE | KeywordsFlags::KEY_STABLE);
+		}
+		return KeywordsFlags::KEY_SOMESTABLE;
+	}
+	KeywordsFlags::KeyType m(KeywordsFlags::KEY_EMPTY);
+	bool found(accepted.accepts(s, len));
+	if(found) {
+		m = (KeywordsFlags::KEY_STABLE | KeywordsFlags::KEY_SOMESTABLE);
+	}
+	if(*s != '~') {
+		return (m | (found ? KeywordsFlags::KEY_ARCHSTABLE : KeywordsFlags::KEY_ALIENSTABLE));
+	}
+	if(found) {
+		return (m | KeywordsFlags::KEY_ARCHUNSTABLE);
+	}
+	if(is_keyword(s, len, "~*")) {
+		if(accepted.some_testing) {
+			return (KeywordsFlags::KEY_SOMEUNSTABLE | KeywordsFlags::KEY_STABLE);
+		}
+		return KeywordsFlags::KEY_SOMEUNSTABLE;
+	}
+	if(accepted.accepts(s + 1, len - 1)) {
+		return KeywordsFlags::KEY_ARCHUNSTABLE;
+	}
+	return KeywordsFlags::KEY_ALIENUNSTABLE;
+}
+
+KeywordsFlags::KeyType KeywordsFlags::get_keyflags(const AcceptedKeywords& accepted_keywords, const string& keywords) {
+	KeyType m(KEY_EMPTY);
+	// The keywords are scanned in place: Since the flags of all keywords
+	// are or-ed, neither their order nor duplicates matter.
+	const char *s(keywords.c_str());
+	for(;;) {
+		s += strspn(s, spaces);
+		if(*s == '\0') {
+			break;
 		}
+		string::size_type len(strcspn(s, spaces));
+		m |= keyword_flags(accepted_keywords, s, len);
+		s += len;
 	}
 	if(m & KEY_STABLE) {
 		return m;
 	}
-	if(accepted_keywords.find("**") != accepted_keywords.end()) {
+	if(accepted_keywords.double_asterisk) {
 		return (m | KEY_STABLE);
 	}
 	if(m & KEY_SOMESTABLE) {
-		if(accepted_keywords.find("*") != accepted_keywords.end()) {
+		if(accepted_keywords.asterisk) {
 			return (m | KEY_STABLE);
 		}
 	}
 	if(m & KEY_TILDESTARMATCH) {
-		if(accepted_keywords.find("~*") != accepted_keywords.end()) {
+		if(accepted_keywords.tilde_asterisk) {
 			return (m | KEY_STABLE);
 		}
 	}
@@ -117,6 +117,35 @@ inline static bool operator!=(MaskFlags const& left, MaskFlags const& right) {
 	return (left.get() != right.get());
 }
 
+/** The accepted keywords in a form which makes repeated calls of
+    KeywordsFlags::get_keyflags() cheap */
+class AcceptedKeywords {
+	public:
+		/** Some keyword without '~' or '-' is accepted */
+		bool some_not_testing;
+		/** Some keyword with '~' is accepted */
+		bool some_testing;
+		/** "**", "*", or "~*" is accepted */
+		bool double_asterisk, asterisk, tilde_asterisk;
+
+		AcceptedKeywords() {
+			init(WordSet());
+		}
+
+		explicit AcceptedKeywords(const WordSet& accepted_keywords) {
+			init(accepted_keywords);
+		}
+
+		void init(const WordSet& accepted_keywords);
+
+		/** @return true if the keyword s of length len is accepted */
+		bool accepts(const char *s, std::string::size_type len) const ATTRIBUTE_NONNULL_ ATTRIBUTE_PURE;
+
+	private:
+		/** Usually, there are only very few accepted keywords */
+		WordVec m_words;
+};
+
 class KeywordsFlags {
 	public:
 		typedef eix::UChar KeyType;
@@ -134,7 +163,10 @@ class KeywordsFlags {
 			KEY_SOMEUNSTABLE   = KEY_ARCHUNSTABLE|KEY_ALIENUNSTABLE,
 			KEY_TILDESTARMATCH = KEY_SOMESTABLE|KEY_SOMEUNSTABLE;
 
-		static KeyType get_keyflags(const WordSet& accepted_keywords, const std::string& keywords);
+		static KeyType get_keyflags(const AcceptedKeywords& accepted_keywords, const std::string& keywords) ATTRIBUTE_PURE;
+		static KeyType get_keyflags(const WordSet& accepted_keywords, const std::string& keywords) {
+			return get_keyflags(AcceptedKeywords(accepted_keywords), keywords);
+		}
 
 		KeywordsFlags() : m_keyword(KEY_EMPTY) {
 		}
@@ -17,6 +17,7 @@
 #include <string>
 #include <vector>
 
+#include "eixTk/globindex.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
 #include "eixTk/ptr_list.h"
@@ -64,6 +65,9 @@ template<typename m_Type> class MaskList {
 		ExactType exact_name;
 		FullType full_name;
 
+		/** The keys of full_name for matching them in one pass */
+		GlobIndex full_index;
+
 	public:
 		typedef typename eix::ptr_list<const m_Type> Get;
 
@@ -74,6 +78,7 @@ template<typename m_Type> class MaskList {
 		void clear() {
 			exact_name.clear();
 			full_name.clear();
+			full_index.clear();
 		}
 
 		inline static bool match_full(const std::string& mask, const std::string& name) {
@@ -84,13 +89,7 @@ template<typename m_Type> class MaskList {
 			if(exact_name.find(full) != exact_name.end()) {
 				return true;
 			}
-			for(full_const_iterator it(full_name.begin());
-				likely(it != full_name.end()); ++it) {
-				if(unlikely(match_full(it->first, full))) {
-					return true;
-				}
-			}
-			return false;
+			return full_index.matches(full);
 		}
 
 		bool match_name(const Package *p) const ATTRIBUTE_NONNULL_ {
@@ -108,10 +107,12 @@ template<typename m_Type> class MaskList {
 
 		Get *get_full(const std::string& full) const {
 			Get *l(NULLPTR);
-			for(full_const_iterator it(full_name.begin());
-				likely(it != full_name.end()); ++it) {
-				if(unlikely(match_full(it->first, full))) {
-					push_result(&l, it->second);
+			if(!full_index.empty()) {
+				GlobIndex::Result r;
+				full_index.match(&r, full);
+				for(GlobIndex::Result::const_iterator i(r.begin());
+					unlikely(i != r.end()); ++i) {
+					push_result(&l, full_name.find(full_index[*i])->second);
 				}
 			}
 			exact_const_iterator it(exact_name.find(full));
@@ -137,6 +138,9 @@ template<typename m_Type> class MaskList {
 				exact_name[full].add(m);
 				return;
 			}
+			if(full_name.find(full) == full_name.end()) {
+				full_index.add(full);
+			}
 			full_name[full].add(m);
 		}
 
@@ -9,6 +9,9 @@
 
 #include <config.h>
 
+#include <algorithm>
+#include <cstring>
+
 #include "eixTk/likely.h"
 #include "portage/basicversion.h"
 #include "portage/extendedversion.h"
@@ -33,8 +36,14 @@ const Package::Versioncollects
 	Package::COLLECT_HAVE_MAIN_REPO_KEY,
 	Package::COLLECT_DEFAULT;
 
+/** Order of versions ignoring the overlay.
+    The versions of a package are sorted with respect to this order first. */
+static bool basic_less(const Version *a, const Version *b) {
+	return (BasicVersion::compare(*a, *b) < 0);
+}
+
 /** Check if a package has duplicated versions. */
-void Package::checkDuplicates(const Version *version) {
+void Package::checkDuplicates(const Version *version, const_iterator b, const_iterator e) {
 	if(have_duplicate_versions == DUP_OVERLAYS) {
 		return;
 	}
@@ -42,28 +51,103 @@ void Package::checkDuplicates(const Version *version) {
 	if(no_overlay && (have_duplicate_versions == DUP_SOME)) {
 		return;
 	}
-	for(iterator i(begin()); likely(i != end()); ++i) {
-		if(unlikely(BasicVersion::compare(**i, *version) == 0)) {
-			if(i->overlay_key) {
-				have_duplicate_versions = DUP_OVERLAYS;
-				return;
-			}
-			have_duplicate_versions = DUP_SOME;
-			if(no_overlay) {
-				return;
-			}
+	for(; b != e; ++b) {
+		if(b->overlay_key) {
+			have_duplicate_versions = DUP_OVERLAYS;
+			return;
+		}
+		have_duplicate_versions = DUP_SOME;
+		if(no_overlay) {
+			return;
 		}
 	}
 }
 
-void Package::sortedPushBack(Version *v) {
-	for(iterator i(begin()); likely(i != end()); ++i) {
-		if(*v < **i) {
-			insert(i, v);
-			return;
+/** Versions are mostly added in increasing order; otherwise, the range of
+    equal versions is found by binary search. Within this range, version is
+    inserted before the first larger one (with respect to the overlay). */
+void Package::addVersionStart(Version *version) {
+	if(likely(empty()) || likely(basic_less(back(), version))) {
+		push_back(version);
+		return;
+	}
+	base_vector::iterator b(std::lower_bound(begin(), end(), version, basic_less));
+	base_vector::iterator e(std::upper_bound(b, end(), version, basic_less));
+	checkDuplicates(version, const_iterator(b), const_iterator(e));
+	for(; b != e; ++b) {
+		if(*version < **b) {
+			break;
+		}
+	}
+	insert(b, version);
+}
+
+bool Package::is_before(const Version *a, const Version *b) const {
+	eix::SignedBool r(BasicVersion::compare(*a, *b));
+	if(likely(r != 0)) {
+		return (r < 0);
+	}
+	if(a == b) {
+		return false;
+	}
+	// Equal versions from different overlays: The first in the list wins
+	for(base_vector::const_iterator it(std::lower_bound(begin(), end(), a, basic_less));
+		likely(it != end()); ++it) {
+		if(*it == a) {
+			return true;
+		}
+		if(*it == b) {
+			return false;
+		}
+	}
+	return false;
+}
+
+void Package::insert_slot(Version *version) {
+	const char *slot_name((version->slotname).c_str());
+	SlotList::iterator slot(m_slotlist.begin());
+	for(; likely(slot != m_slotlist.end()); ++slot) {
+		if(unlikely(strcmp(slot_name, slot->slotname()) == 0)) {
+			break;
+		}
+	}
+	if(slot == m_slotlist.end()) {
+		// A new slot is inserted before the first slot with a larger version
+		for(slot = m_slotlist.begin(); likely(slot != m_slotlist.end()); ++slot) {
+			if(is_before(version, slot->const_version_list().front())) {
+				break;
+			}
+		}
+		m_slotlist.insert(slot, SlotVersions(slot_name, version));
+		return;
+	}
+	VersionList& versions(slot->version_list());
+	if(likely(is_before(versions.back(), version))) {
+		versions.push_back(version);
+		return;
+	}
+	// Binary search for the first version after version
+	VersionList::size_type lo(0), hi(versions.size() - 1);
+	while(lo < hi) {
+		VersionList::size_type mid((lo + hi) / 2);
+		if(is_before(versions[mid], version)) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	versions.insert(versions.begin() + lo, version);
+	if(lo != 0) {
+		return;
+	}
+	// The slot got a new first version, so it might have to move forward
+	for(; slot != m_slotlist.begin(); --slot) {
+		SlotList::iterator prev(slot - 1);
+		if(!is_before(version, prev->const_version_list().front())) {
+			break;
 		}
+		std::swap(*slot, *prev);
 	}
-	push_back(v);
 }
 
 void Package::collect_iuse(Version *version) {
@@ -103,12 +187,10 @@ void Package::addVersionFinalize(Version *version) {
 
 	collect_iuse(version);
 
-	// We must recalculate the complete slotlist after each modification.
-	// The reason is that the pointers might go into nirvana, because
-	// a push_back might move the whole list.
+	insert_slot(version);
 
-	// Mark current slotlist as invalid.
-	m_has_cached_slotlist = m_has_cached_subslots = false;
+	// Mark the cache of guess_slotname() as invalid.
+	m_has_cached_subslots = false;
 }
 
 /** Call this after modifying system or world state of versions */
@@ -10,7 +10,6 @@
 #ifndef SRC_PORTAGE_PACKAGE_H_
 #define SRC_PORTAGE_PACKAGE_H_ 1
 
-#include <list>
 #include <map>
 #include <string>
 #include <vector>
@@ -20,6 +19,7 @@
 #include "eixTk/inttypes.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
+#include "eixTk/pool.h"
 #include "eixTk/ptr_list.h"
 #include "portage/basicversion.h"
 #include "portage/extendedversion.h"
@@ -32,9 +32,9 @@ class PortageSettings;
 
 /** A sorted list of pointer to Versions */
 
-class VersionList : public std::list<Version*> {  // null entries are not allowed
+class VersionList : public std::vector<Version*> {  // null entries are not allowed
 	public:
-		explicit VersionList(Version *v) ATTRIBUTE_NONNULL_ : std::list<Version*>(1, v) {
+		explicit VersionList(Version *v) ATTRIBUTE_NONNULL_ : std::vector<Version*>(1, v) {
 		}
 
 		Version* best(bool allow_unstable) const ATTRIBUTE_PURE;
@@ -68,13 +68,12 @@ class SlotVersions {
 /** This list is always sorted with respect to the first version for each slot */
 class SlotList : public std::vector<SlotVersions> {
 	public:
-		void push_back_largest(Version *version) ATTRIBUTE_NONNULL_;
 		const VersionList *operator[](const char *s) const ATTRIBUTE_NONNULL_ ATTRIBUTE_PURE;
 };
 
 /** A class to represent a package in portage It contains various information
  * about a package, including a sorted(!) list of versions. */
-class Package : public eix::ptr_list<Version> {
+class Package : public eix::ptr_vector<Version>, public eix::Pooled {
 	public:
 		typedef std::vector<Version *> VerVec;
 
@@ -118,10 +117,6 @@ class Package : public eix::ptr_list<Version> {
 		bool calc_allow_upgrade_slots(const PortageSettings *ps) const ATTRIBUTE_NONNULL_;
 
 		const SlotList& slotlist() const {
-			if(!m_has_cached_slotlist) {
-				build_slotlist();
-				m_has_cached_slotlist = true;
-			}
 			return m_slotlist;
 		}
 
@@ -183,10 +178,7 @@ class Package : public eix::ptr_list<Version> {
 		    Only BasicVersion needs to be filled here.
 		    You must call addVersionFinalize() after filling
 		    the remaining data */
-		void addVersionStart(Version *version) {
-			checkDuplicates(version);
-			sortedPushBack(version);
-		}
+		void addVersionStart(Version *version) ATTRIBUTE_NONNULL_;
 
 		/** Finishes addVersion() after the remaining data
 		    have been filled */
@@ -253,7 +245,7 @@ class Package : public eix::ptr_list<Version> {
 			return best(false);
 		}
 
-		Version *best_slot(const char *slot_name, bool allow_unstable) const ATTRIBUTE_NONNULL_;
+		Version *best_slot(const char *slot_name, bool allow_unstable) const ATTRIBUTE_NONNULL_ ATTRIBUTE_PURE;
 		Version *best_slot(const char *slot_name) const ATTRIBUTE_NONNULL_ {
 			return best_slot(slot_name, false);
 		}
@@ -275,7 +267,7 @@ class Package : public eix::ptr_list<Version> {
 			-  3: p has no worse/missing best_slot, but an
 			      identical from a different overlay
 			-  0: else */
-		eix::TinySigned worse_best_slots(const Package& p) const;
+		eix::TinySigned worse_best_slots(const Package& p) const ATTRIBUTE_PURE;
 
 		/** Compare best_slots() versions with that of p.
 		    @return
@@ -284,7 +276,7 @@ class Package : public eix::ptr_list<Version> {
 			- -1: *this has a worse/missing best_slot, and p has not
 			-  2: p and *this both have a worse/missing best_slot
 			-  3: all matches, but at least one overlay differs */
-		eix::TinySigned compare_best_slots(const Package& p) const;
+		eix::TinySigned compare_best_slots(const Package& p) const ATTRIBUTE_PURE;
 
 		/** Compare best() version with that of p.
 		    @return
@@ -400,30 +392,31 @@ class Package : public eix::ptr_list<Version> {
 		/** \c slotlist is always sorted with respect to the
 		    first version. Moreover, this list is complete, i.e. it
 		    contains also the trivial slot (-> each version is
-		    contained exactly in one slot) */
-		mutable SlotList m_slotlist;
-		mutable bool m_has_cached_slotlist;
+		    contained exactly in one slot).
+		    It is kept up to date by addVersionFinalize(). */
+		SlotList m_slotlist;
 
 		/// This is for caching in guess_slotname
 		mutable bool m_has_cached_subslots, m_unique_subslot;
 		mutable std::string m_subslot;
 
-		/// Create new slotlist. Const because we operate on mutable cache
-		/// types.
-		void build_slotlist() const;
+		/** Add version to the slotlist after its slot is known */
+		void insert_slot(Version *version) ATTRIBUTE_NONNULL_;
+
+		/** Whether version a is before version b in the list of versions.
+		    Both must be in the list. */
+		bool is_before(const Version *a, const Version *b) const ATTRIBUTE_NONNULL_ ATTRIBUTE_PURE;
 
 		/** This is called by addVersionFinalize() to calculate
 		    collected iuse and to save memory by freeing version iuse */
 		void collect_iuse(Version *version) ATTRIBUTE_NONNULL_;
 
-		/** Check if a package has duplicated versions. */
-		void checkDuplicates(const Version *version) ATTRIBUTE_NONNULL_;
-
-		void sortedPushBack(Version *version) ATTRIBUTE_NONNULL_;
+		/** Check if a package has duplicated versions.
+		    @param [b, e) are the versions equal to version. */
+		void checkDuplicates(const Version *version, const_iterator b, const_iterator e) ATTRIBUTE_NONNULL((2));
 
 		void defaults() {
-			know_upgrade_slots = m_has_cached_slotlist =
-				m_has_cached_subslots = false;
+			know_upgrade_slots = m_has_cached_subslots = false;
 			have_duplicate_versions = DUP_NONE;
 			version_collects = COLLECT_DEFAULT;
 			local_collects.set(MaskFlags::MASK_NONE);
@@ -40,17 +40,6 @@ Version *VersionList::best(bool allow_unstable) const {
 	return NULLPTR;
 }
 
-void SlotList::push_back_largest(Version *version) {
-	const char *name((version->slotname).c_str());
-	for(iterator it(begin()); likely(it != end()); ++it) {
-		if(unlikely(strcmp(name, it->slotname()) == 0)) {
-			(it->version_list()).push_back(version);
-			return;
-		}
-	}
-	push_back(SlotVersions(name, version));
-}
-
 const VersionList *SlotList::operator[](const char *s) const {
 	for(const_iterator it(begin()); likely(it != end()); ++it) {
 		if(unlikely(strcmp(s, it->slotname()) == 0)) {
@@ -78,14 +67,6 @@ Version *Package::best(bool allow_unstable) const {
 	return NULLPTR;
 }
 
-void Package::build_slotlist() const {
-	m_slotlist.clear();
-	for(const_iterator it(begin()); likely(it != end()); ++it) {
-		m_slotlist.push_back_largest(*it);
-	}
-}
-
-
 Version *Package::best_slot(const char *slot_name, bool allow_unstable) const {
 	const VersionList *vl(slotlist()[slot_name]);
 	if(vl == NULLPTR) {
@@ -23,23 +23,29 @@ using std::pair;
 using std::string;
 
 Category::iterator Category::find(const std::string& pkg_name) {
-	iterator i(begin());
-	for(; likely(i != end()); ++i) {
-		if(unlikely(i->name == pkg_name)) {
-			return i;
-		}
-	}
-	return i;
+	NameIndex::const_iterator f(m_index.find(pkg_name));
+	return ((f == m_index.end()) ? iterator(end()) : f->second);
 }
 
 Category::const_iterator Category::find(const std::string& pkg_name) const {
-	const_iterator i(begin());
-	for(; likely(i != end()); ++i) {
-		if(unlikely(i->name == pkg_name)) {
-			return i;
-		}
+	NameIndex::const_iterator f(m_index.find(pkg_name));
+	if(f == m_index.end()) {
+		return const_iterator(end());
+	}
+	return const_iterator(PackageList::base_list::const_iterator(f->second));
+}
+
+void Category::push_back(Package *pkg) {
+	PackageList::push_back(pkg);
+	m_index.insert(NameIndex::value_type(pkg->name, iterator(--end())));
+}
+
+Category::iterator Category::erase(iterator i) {
+	NameIndex::iterator f(m_index.find(i->name));
+	if(likely(f != m_index.end()) && likely(f->second == i)) {
+		m_index.erase(f);
 	}
-	return i;
+	return iterator(PackageList::erase(i));
 }
 
 #if 0
@@ -20,8 +20,26 @@
 
 class Package;
 
-class Category : public eix::ptr_list<Package> {
+/** The packages of a category in the order in which they were added.
+    An index of the package names makes the lookup logarithmic instead of
+    linear; therefore, the list can only be modified through this class. */
+class Category : private eix::ptr_list<Package> {
+	private:
+		typedef eix::ptr_list<Package> PackageList;
+		typedef std::map<std::string, PackageList::iterator> NameIndex;
+
+		/** The position of each package name (of the first if not unique) */
+		NameIndex m_index;
+
 	public:
+		typedef PackageList::iterator iterator;
+		typedef PackageList::const_iterator const_iterator;
+		typedef PackageList::size_type size_type;
+		using PackageList::begin;
+		using PackageList::end;
+		using PackageList::size;
+		using PackageList::empty;
+
 		Category() {
 		}
 
@@ -37,11 +55,33 @@ class Category : public eix::ptr_list<Package> {
 			return ((i == end()) ? NULLPTR : (*i));
 		}
 
+		void push_back(Package *pkg) ATTRIBUTE_NONNULL_;
+
 		void addPackage(Package *pkg) ATTRIBUTE_NONNULL_ {
 			push_back(pkg);
 		}
 
 		Package *addPackage(const std::string cat_name, const std::string& pkg_name);
+
+		/** Remove the package at i from the list without deleting it.
+		 * @return the position after i */
+		iterator erase(iterator i);
+
+		void clear() {
+			m_index.clear();
+			PackageList::clear();
+		}
+
+		void delete_and_clear() {
+			m_index.clear();
+			PackageList::delete_and_clear();
+		}
+
+		/** Move all packages to the end of *dest. */
+		void splice_to(eix::ptr_list<Package> *dest) ATTRIBUTE_NONNULL_ {
+			m_index.clear();
+			dest->splice(dest->end(), *this);
+		}
 };
 
 class PackageTree : public std::map<std::string, Category*> {
@@ -16,15 +16,20 @@
 #include <algorithm>
 #include <iostream>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "database/header.h"
+#include "database/vardb_index.h"
 #include "eixTk/diagnostics.h"
 #include "eixTk/eixint.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
+#include "eixTk/ptr_list.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
 #include "eixTk/sysutils.h"
+#include "eixTk/threads.h"
 #include "eixTk/utils.h"
 #include "portage/basicversion.h"
 #include "portage/extendedversion.h"
@@ -32,6 +37,7 @@
 #include "portage/vardbpkg.h"
 
 using std::string;
+using std::vector;
 
 using std::cerr;
 using std::endl;
@@ -163,16 +169,13 @@ bool VarDbPkg::readOverlay(const Package& p, InstVersion *v, const DBHeader& hea
 
 string VarDbPkg::readOverlayLabel(const Package *p, const BasicVersion *v) const {
 	LineVec lines;
-	string dirname(m_directory);
-	dirname.append(p->category);
+	string dirname(p->category);
 	dirname.append(1, '/');
 	dirname.append(p->name);
 	dirname.append(1, '-');
 	dirname.append(v->getFull());
-	pushback_lines((dirname + "/repository").c_str(),
-		&lines, false, false, 1);
-	pushback_lines((dirname + "/REPOSITORY").c_str(),
-		&lines, false, false, 1);
+	readLines(dirname, VarDbIndex::REPOSITORY_FILE, &lines);
+	readLines(dirname, VarDbIndex::REPOSITORY_OLD_FILE, &lines);
 	if(lines.empty()) {
 		return "";
 	}
@@ -187,9 +190,8 @@ bool VarDbPkg::readSlot(const Package& p, InstVersion *v) const {
 	if(v->read_failed)
 		return false;
 	LineVec lines;
-	if(unlikely(!pushback_lines(
-		(m_directory + p.category + "/" + p.name + "-" + v->getFull() + "/SLOT").c_str(),
-		&lines, false, false, 1))) {
+	if(unlikely(!readLines(p.category + "/" + p.name + "-" + v->getFull(),
+		VarDbIndex::SLOT_FILE, &lines))) {
 		return (v->read_failed = true);
 	}
 	if((lines.empty()) || (lines[0] == "0")) {
@@ -208,17 +210,15 @@ bool VarDbPkg::readUse(const Package& p, InstVersion *v) const {
 	v->usedUse.clear();
 	WordSet iuse_set;
 	WordVec alluse;
-	string dirname(m_directory + p.category + "/" + p.name + "-" + v->getFull());
+	string dirname(p.category + "/" + p.name + "-" + v->getFull());
 	LineVec lines;
-	if(unlikely(!pushback_lines((dirname + "/IUSE").c_str(),
-		&lines, false, false, 1))) {
+	if(unlikely(!readLines(dirname, VarDbIndex::IUSE_FILE, &lines))) {
 		return false;
 	}
 	join_and_split(&(v->inst_iuse), lines);
 
 	lines.clear();
-	if(unlikely(!pushback_lines((dirname + "/USE").c_str(),
-		&lines, false, false, 1))) {
+	if(unlikely(!readLines(dirname, VarDbIndex::USE_FILE, &lines))) {
 		return false;
 	}
 	join_and_split(&alluse, lines);
@@ -264,10 +264,9 @@ void VarDbPkg::readRestricted(const Package& p, InstVersion *v, const DBHeader&
 			return;
 		}
 	}
-	string dirname(m_directory + p.category + "/" + p.name + "-" + v->getFull());
 	LineVec lines;
-	if(unlikely(!pushback_lines((dirname + "/RESTRICT").c_str(),
-		&lines, false, false, 1))) {
+	if(unlikely(!readLines(p.category + "/" + p.name + "-" + v->getFull(),
+		VarDbIndex::RESTRICT_FILE, &lines))) {
 		// It is OK that this file does not exist:
 		// Portage does this if RESTRICT is not set.
 		v->restrictFlags = ExtendedVersion::RESTRICT_NONE;
@@ -284,11 +283,10 @@ void VarDbPkg::readInstDate(const Package& p, InstVersion *v) const {
 	if(v->instDate != 0) {
 		return;
 	}
-	string dirname(m_directory + p.category + "/" + p.name + "-" + v->getFull());
+	string dirname(p.category + "/" + p.name + "-" + v->getFull());
 	LineVec datelines;
 	if(use_build_time &&
-		pushback_lines((dirname + "/BUILD_TIME").c_str(),
-			&datelines, false, false, 1)) {
+		readLines(dirname, VarDbIndex::BUILD_TIME_FILE, &datelines)) {
 		for(LineVec::const_iterator it(datelines.begin());
 			it != datelines.end(); ++it) {
 GCC_DIAG_OFF(sign-conversion)
@@ -298,7 +296,7 @@ GCC_DIAG_ON(sign-conversion)
 			}
 		}
 	}
-	v->instDate = get_mtime(dirname.c_str());
+	v->instDate = getMtime(dirname);
 }
 
 void VarDbPkg::readDepend(const Package& p, InstVersion *v, const DBHeader& header) const {
@@ -318,22 +316,15 @@ void VarDbPkg::readDepend(const Package& p, InstVersion *v, const DBHeader& head
 			return;
 		}
 	}
-	string dirname(m_directory + p.category + "/" + p.name + "-" + v->getFull());
+	string dirname(p.category + "/" + p.name + "-" + v->getFull());
 	WordVec depend(4);
 	depend[0] = v->depend.get_depend();
 	depend[1] = v->depend.get_rdepend();
 	depend[2] = v->depend.get_pdepend();
 	depend[3] = v->depend.get_hdepend();
-	static const char *filenames[4] = {
-		"/DEPEND",
-		"/RDEPEND",
-		"/PDEPEND",
-		"/HDEPEND"
-	};
 	for(eix::TinyUnsigned i(0); likely(i < 4); ++i) {
 		LineVec lines;
-		if(likely(pushback_lines((dirname + filenames[i]).c_str(),
-			&lines, false, false, 1))) {
+		if(likely(readLines(dirname, static_cast<VarDbIndex::FileNum>(VarDbIndex::DEPEND_FILE + i), &lines))) {
 			if(likely(lines.size() == 1)) {
 				depend[i].assign(lines[0]);
 			} else {
@@ -345,8 +336,229 @@ void VarDbPkg::readDepend(const Package& p, InstVersion *v, const DBHeader& head
 	v->depend.set(depend[0], depend[1], depend[2], depend[3], true);
 }
 
+void VarDbPkg::useIndex(const string& file) {
+	if(file.empty()) {
+		return;
+	}
+	VarDbIndex *index(new VarDbIndex);
+	if(likely(index->open(file.c_str(), m_directory))) {
+		delete m_index;
+		m_index = index;
+	} else {
+		delete index;
+	}
+}
+
+bool VarDbPkg::readLines(const string& dirname, VarDbIndex::FileNum num, LineVec *lines) const {
+	PrefetchedVersions::iterator pre(m_prefetched.find(dirname));
+	if(pre != m_prefetched.end()) {
+		PrefetchedVersion& version(pre->second);
+		eix::SignedBool state(version.state[num]);
+		if(state >= 0) {
+			version.state[num] = -1;
+			LineVec& prefetched(version.lines[num]);
+			if(lines->empty()) {
+				lines->swap(prefetched);
+			} else {
+				lines->insert(lines->end(), prefetched.begin(), prefetched.end());
+			}
+			prefetched.clear();
+			return (state != 0);
+		}
+	}
+	if(m_index != NULLPTR) {
+		IndexedVersions::iterator it(m_indexed.find(dirname));
+		if(it != m_indexed.end()) {
+			IndexedVersion& version(it->second);
+			if(version.unchanged == 0) {
+				version.unchanged = (m_index->unchanged(version.offset,
+					m_directory + dirname) ? 1 : -1);
+			}
+			if(version.unchanged > 0) {
+				eix::SignedBool r(m_index->read_lines(version.offset, num, lines));
+				if(likely(r >= 0)) {
+					return (r != 0);
+				}
+				version.unchanged = -1;
+			}
+		}
+	}
+	return pushback_lines((m_directory + dirname + "/" + VarDbIndex::filenames[num]).c_str(),
+		lines, false, false, 1);
+}
+
+time_t VarDbPkg::getMtime(const string& dirname) const {
+	PrefetchedVersions::const_iterator pre(m_prefetched.find(dirname));
+	if((pre != m_prefetched.end()) && (pre->second.mtime != 0)) {
+		return pre->second.mtime;
+	}
+	return get_mtime((m_directory + dirname).c_str());
+}
+
+/** The versions to be read in parallel by VarDbPkg::prefetch() */
+class VarDbPrefetch {
+	public:
+		/// The directories of the versions with their data to be filled
+		typedef vector<std::pair<string, VarDbPkg::PrefetchedVersion *> > Work;
+		Work work;
+
+		/// The files to read
+		bool files[VarDbIndex::FILE_COUNT];
+
+		VarDbPrefetch() : m_next(0) {
+		}
+
+		/// @return false if there is no version left
+		bool next(Work::size_type *i) ATTRIBUTE_NONNULL_ {
+			eix::MutexLocker locker(&mutex);
+			if(m_next == work.size()) {
+				return false;
+			}
+			*i = m_next++;
+			return true;
+		}
+
+		static void worker(void *data);
+
+	private:
+		Work::size_type m_next;
+		eix::Mutex mutex;
+};
+
+void VarDbPrefetch::worker(void *data) {
+	VarDbPrefetch *p(static_cast<VarDbPrefetch *>(data));
+	VarDbPrefetch::Work::size_type i;
+	while(likely(p->next(&i))) {
+		const string& dirname(p->work[i].first);
+		VarDbPkg::PrefetchedVersion *version(p->work[i].second);
+		for(VarDbIndex::FileNum num(0); likely(num != VarDbIndex::FILE_COUNT); ++num) {
+			if(!p->files[num]) {
+				continue;
+			}
+			LineVec *lines(&(version->lines[num]));
+			if(pushback_lines((dirname + "/" + VarDbIndex::filenames[num]).c_str(),
+				lines, false, false, 1)) {
+				version->state[num] = 1;
+			} else {
+				lines->clear();
+				version->state[num] = 0;
+			}
+		}
+		version->mtime = get_mtime(dirname.c_str());
+	}
+}
+
+void VarDbPkg::prefetch(const eix::ptr_list<Package>& packages, eix::ptr_list<Package>::size_type max, unsigned int jobs) {
+	VarDbPrefetch data;
+	for(VarDbIndex::FileNum num(0); likely(num != VarDbIndex::FILE_COUNT); ++num) {
+		data.files[num] = false;
+	}
+	data.files[VarDbIndex::SLOT_FILE] = get_slots;
+	data.files[VarDbIndex::IUSE_FILE] = data.files[VarDbIndex::USE_FILE] = true;
+	data.files[VarDbIndex::RESTRICT_FILE] = get_restrictions;
+	data.files[VarDbIndex::BUILD_TIME_FILE] = use_build_time;
+	for(VarDbIndex::FileNum i(0); likely(i < 4); ++i) {
+		data.files[VarDbIndex::DEPEND_FILE + i] = (Depend::use_depend && care_of_deps);
+	}
+
+	eix::ptr_list<Package>::size_type count(0);
+	for(eix::ptr_list<Package>::const_iterator it(packages.begin());
+		likely(it != packages.end()); ++it) {
+		if((max != 0) && unlikely(count++ == max)) {
+			break;
+		}
+		InstVec *vec(getInstalledVector(**it));
+		if(vec == NULLPTR) {
+			continue;
+		}
+		// readOverlay() needs the repository only in this case
+		if((check_installed_overlays != 0) || !(it->have_same_overlay_key())) {
+			data.files[VarDbIndex::REPOSITORY_FILE] =
+				data.files[VarDbIndex::REPOSITORY_OLD_FILE] = true;
+		}
+		string prefix(it->category + "/" + it->name + "-");
+		for(InstVec::const_iterator v(vec->begin()); likely(v != vec->end()); ++v) {
+			string dirname(prefix + v->getFull());
+			if(m_prefetched.find(dirname) != m_prefetched.end()) {
+				continue;
+			}
+			// Versions which are served from the index need not be read
+			IndexedVersions::iterator ind(m_indexed.find(dirname));
+			if(ind != m_indexed.end()) {
+				IndexedVersion& version(ind->second);
+				if(version.unchanged == 0) {
+					version.unchanged = (m_index->unchanged(version.offset,
+						m_directory + dirname) ? 1 : -1);
+				}
+				if(version.unchanged > 0) {
+					continue;
+				}
+			}
+			PrefetchedVersion& version(m_prefetched[dirname]);
+			for(VarDbIndex::FileNum num(0); likely(num != VarDbIndex::FILE_COUNT); ++num) {
+				version.state[num] = -1;
+			}
+			version.mtime = 0;
+			data.work.push_back(std::make_pair(m_directory + dirname, &version));
+		}
+	}
+	if(data.work.empty()) {
+		return;
+	}
+	if(jobs > data.work.size()) {
+		jobs = static_cast<unsigned int>(data.work.size());
+	}
+	eix::run_parallel(jobs, VarDbPrefetch::worker, &data);
+}
+
+bool VarDbPkg::addEntry(InstVecPkg *category_installed, const char *name) {
+	if(name[0] == '.')
+		return false;  /* Don't want dot-stuff */
+	char **aux(ExplodeAtom::split(name));
+	if(aux == NULLPTR)
+		return false;
+	string errtext;
+	InstVersion instver;
+	BasicVersion::ParseResult r(instver.parseVersion(aux[1], &errtext));
+	if(unlikely(r != BasicVersion::parsedOK)) {
+		cerr << errtext << endl;
+	}
+	bool added(likely(r != BasicVersion::parsedError));
+	if(added) {
+		(*category_installed)[aux[0]].push_back(instver);
+	}
+	free(aux[0]);
+	free(aux[1]);
+	return added;
+}
+
 /** Read category from db-directory. */
 void VarDbPkg::readCategory(const char *category) {
+	InstVecPkg *category_installed;
+	if(m_index != NULLPTR) {
+		VarDbIndex::Entries entries;
+		eix::SignedBool found(m_index->read_category(category, &entries));
+		if(found == 0) {
+			installed[category] = NULLPTR;
+			return;
+		}
+		if(found > 0) {
+			installed[category] = category_installed = new InstVecPkg;
+			string prefix(category);
+			prefix.append(1, '/');
+			for(VarDbIndex::Entries::const_iterator it(entries.begin());
+				likely(it != entries.end()); ++it) {
+				if(addEntry(category_installed, it->first.c_str())) {
+					IndexedVersion& version(m_indexed[prefix + it->first]);
+					version.offset = it->second;
+					version.unchanged = 0;
+				}
+			}
+			sort_installed(category_installed);
+			return;
+		}
+	}
+
 	/* Pointer to category DIRectory */
 	DIR *dir_category;
 
@@ -358,30 +570,14 @@ void VarDbPkg::readCategory(const char *category) {
 		return;
 	}
 	dir_category_name.append(1, '/');
-	InstVecPkg *category_installed;
 	installed[category] = category_installed = new InstVecPkg;
 
 	struct dirent *package_entry;  /* current package dirent */
 	/* Cycle through this category */
 	while(likely((package_entry = readdir(dir_category)) != NULLPTR)) {  // NOLINT(runtime/threadsafe_fn)
-		if(package_entry->d_name[0] == '.')
-			continue;  /* Don't want dot-stuff */
-		char **aux(ExplodeAtom::split( package_entry->d_name));
-		if(aux == NULLPTR)
-			continue;
-		string errtext;
-		InstVersion instver;
-		BasicVersion::ParseResult r(instver.parseVersion(aux[1], &errtext));
-		if(unlikely(r != BasicVersion::parsedOK)) {
-			cerr << errtext << endl;
-		}
-		if(likely(r != BasicVersion::parsedError)) {
-			(*category_installed)[aux[0]].push_back(instver);
-		}
-		free(aux[0]);
-		free(aux[1]);
+		addEntry(category_installed, package_entry->d_name);
 	}
 	closedir(dir_category);
-	sort_installed(installed[category]);
+	sort_installed(category_installed);
 }
 
@@ -10,13 +10,18 @@
 #ifndef SRC_PORTAGE_VARDBPKG_H_
 #define SRC_PORTAGE_VARDBPKG_H_ 1
 
+#include <ctime>
+
 #include <map>
 #include <string>
 #include <vector>
 
+#include "database/vardb_index.h"
 #include "eixTk/eixint.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
+#include "eixTk/ptr_list.h"
+#include "eixTk/stringtypes.h"
 #include "portage/basicversion.h"
 #include "portage/instversion.h"
 #include "portage/package.h"
@@ -27,6 +32,8 @@ class DBHeader;
 typedef std::vector<InstVersion> InstVec;
 /** Holds every installed version of a package. */
 class VarDbPkg {
+	friend class VarDbPrefetch;
+
 	private:
 		typedef std::map<std::string, InstVec> InstVecPkg;
 		typedef std::map<std::string, InstVecPkg *> InstVecCat;
@@ -37,6 +44,44 @@ class VarDbPkg {
 		bool get_slots, care_of_slots, care_of_deps;
 		bool get_restrictions, care_of_restrictions, use_build_time;
 
+		/** The index of the installed packages or NULLPTR */
+		VarDbIndex *m_index;
+
+		/** Where the versions of the categories read from m_index are
+		    stored, and whether their directories are unchanged (if known) */
+		class IndexedVersion {
+			public:
+				eix::OffsetType offset;
+				eix::SignedBool unchanged;
+		};
+		typedef std::map<std::string, IndexedVersion> IndexedVersions;
+		mutable IndexedVersions m_indexed;
+
+		/** The files of installed versions read in advance by prefetch().
+		    A file is served only once; afterwards it is read again. */
+		class PrefetchedVersion {
+			public:
+				/// 1 if the file was read, 0 if it is missing, -1 if not read
+				eix::SignedBool state[VarDbIndex::FILE_COUNT];
+				LineVec lines[VarDbIndex::FILE_COUNT];
+				time_t mtime;
+		};
+		typedef std::map<std::string, PrefetchedVersion> PrefetchedVersions;
+		mutable PrefetchedVersions m_prefetched;
+
+		/** Add the version of the entry name of a category directory.
+		 * @return false if name is not an installed version. */
+		static bool addEntry(InstVecPkg *category_installed, const char *name) ATTRIBUTE_NONNULL_;
+
+		/** Read file num of an installed version from m_index if possible
+		 * or from the db-directory otherwise.
+		 * @param dirname the directory of the version relative to the db-directory. */
+		bool readLines(const std::string& dirname, VarDbIndex::FileNum num, LineVec *lines) const ATTRIBUTE_NONNULL_;
+
+		/** The mtime of the directory of an installed version.
+		 * @param dirname the directory of the version relative to the db-directory. */
+		time_t getMtime(const std::string& dirname) const;
+
 		/** Find installed versions of packet "name" in category "category".
 		 * @return NULLPTR if not found .. else pointer to vector of versions. */
 		InstVec *getInstalledVector(const std::string& category, const std::string& name);
@@ -55,16 +100,29 @@ class VarDbPkg {
 			care_of_deps(care_about_deps),
 			get_restrictions(calc_restrictions),
 			care_of_restrictions(care_about_restrictions),
-			use_build_time(build_time) {
+			use_build_time(build_time),
+			m_index(NULLPTR) {
 		}
 
 		~VarDbPkg() {
+			delete m_index;
 			for(InstVecCat::iterator it(installed.begin());
 				likely(it != installed.end()); ++it) {
 				delete it->second;
 			}
 		}
 
+		/** Use the index of the installed packages in file if it exists
+		 * and belongs to the db-directory. */
+		void useIndex(const std::string& file);
+
+		/** Read the files of the installed versions of the first max packages
+		 * (all if max is 0) in jobs parallel threads, so that the read*
+		 * functions need not access the disk for them afterwards.
+		 * Only files are read which might be needed with the current
+		 * settings and which cannot be served from the index. */
+		void prefetch(const eix::ptr_list<Package>& packages, eix::ptr_list<Package>::size_type max, unsigned int jobs);
+
 		bool care_slots() const {
 			return care_of_slots;
 		}
@@ -17,6 +17,7 @@
 
 #include "eixTk/constexpr.h"
 #include "eixTk/eixint.h"
+#include "eixTk/pool.h"
 #include "eixTk/stringlist.h"
 #include "eixTk/stringtypes.h"
 #include "portage/basicversion.h"
@@ -66,7 +67,7 @@ class IUse : public std::string {
 
 class IUseSet {
 	public:
-		typedef std::set<IUse> IUseStd;
+		typedef std::set<IUse, std::less<IUse>, eix::PoolAllocator<IUse> > IUseStd;
 
 		bool empty() const {
 			return m_iuse.empty();
@@ -92,6 +93,12 @@ class IUseSet {
 			insert(IUse(iuse));
 		}
 
+		/** Insert an element which does not occur yet and is usually
+		    larger than all others (as when reading the database) */
+		void push_back(const IUse& iuse) {
+			m_iuse.insert(m_iuse.end(), iuse);
+		}
+
 		std::string asString() const;
 
 		WordVec asVector() const;
@@ -104,7 +111,7 @@ class IUseSet {
 
 /** Version expands the BasicVersion class by data relevant for versions in tree/overlays.
  */
-class Version : public ExtendedVersion, public Keywords {
+class Version : public ExtendedVersion, public Keywords, public eix::Pooled {
 	public:
 		typedef std::set<StringList> Reasons;
 
@@ -241,14 +248,18 @@ class Version : public ExtendedVersion, public Keywords {
 			return ((effective_state == EFFECTIVE_USED) ? effective_keywords : full_keywords);
 		}
 
-		KeywordsFlags::KeyType get_keyflags(const WordSet& accepted_keywords) const {
+		KeywordsFlags::KeyType get_keyflags(const AcceptedKeywords& accepted_keywords) const {
 			if(effective_state == EFFECTIVE_USED) {
 				return KeywordsFlags::get_keyflags(accepted_keywords, effective_keywords);
 			}
 			return KeywordsFlags::get_keyflags(accepted_keywords, full_keywords);
 		}
 
-		void set_keyflags(const WordSet& accepted_keywords) {
+		KeywordsFlags::KeyType get_keyflags(const WordSet& accepted_keywords) const {
+			return get_keyflags(AcceptedKeywords(accepted_keywords));
+		}
+
+		void set_keyflags(const AcceptedKeywords& accepted_keywords) {
 			keyflags.set_keyflags(get_keyflags(accepted_keywords));
 		}
 
@@ -50,7 +50,7 @@ bool FuzzyAlgorithm::compare(Package *p1, Package *p2) {
 
 bool FuzzyAlgorithm::operator()(const char *s, Package *p) {
 	eix_assert_static(levenshtein_map != NULLPTR);
-	Levenshtein d(get_levenshtein_distance(search_string.c_str(), s));
+	Levenshtein d(pattern.distance(s, max_levenshteindistance));
 	bool ok(d <= max_levenshteindistance);
 	if(ok) {
 		if(p != NULLPTR) {
@@ -13,6 +13,7 @@
 #include <map>
 #include <string>
 
+#include "database/trigrams.h"
 #include "eixTk/regexp.h"
 #include "eixTk/unused.h"
 #include "search/levenshtein.h"
@@ -31,6 +32,25 @@ class BaseAlgorithm {
 			search_string = s;
 		}
 
+		const std::string& getString() const {
+			return search_string;
+		}
+
+		/** @return true if the algorithm matches only search_string itself */
+		virtual bool is_exact() const {
+			return false;
+		}
+
+		/** @return true if operator() can be called in parallel threads */
+		virtual bool can_match_parallel() const {
+			return true;
+		}
+
+		/** Add the trigrams which every matching string must contain */
+		virtual void get_trigrams(TrigramSet *trigrams ATTRIBUTE_UNUSED) const {
+			UNUSED(trigrams);
+		}
+
 		virtual ~BaseAlgorithm() {
 			// Nothin' to see here, please move along
 		}
@@ -60,12 +80,24 @@ class RegexAlgorithm : public BaseAlgorithm {
 			UNUSED(p);
 			return re.match(s);
 		}
+
+		void get_trigrams(TrigramSet *trigrams) const {
+			add_regex_trigrams(trigrams, search_string);
+		}
 };
 
 /** exact string matching */
 class ExactAlgorithm : public BaseAlgorithm {
 	public:
 		bool operator()(const char *s, Package *p ATTRIBUTE_UNUSED) ATTRIBUTE_NONNULL((2)) ATTRIBUTE_PURE;
+
+		bool is_exact() const {
+			return true;
+		}
+
+		void get_trigrams(TrigramSet *trigrams) const {
+			add_trigrams(trigrams, search_string);
+		}
 };
 
 /** substring matching */
@@ -75,18 +107,30 @@ class SubstringAlgorithm : public BaseAlgorithm {
 			UNUSED(p);
 			return (std::string(s).find(search_string) != std::string::npos);
 		}
+
+		void get_trigrams(TrigramSet *trigrams) const {
+			add_trigrams(trigrams, search_string);
+		}
 };
 
 /** begin-of-string matching */
 class BeginAlgorithm : public BaseAlgorithm {
 	public:
 		bool operator()(const char *s, Package *p ATTRIBUTE_UNUSED) ATTRIBUTE_NONNULL((2)) ATTRIBUTE_PURE;
+
+		void get_trigrams(TrigramSet *trigrams) const {
+			add_trigrams(trigrams, search_string);
+		}
 };
 
 /** end-of-string matching */
 class EndAlgorithm : public BaseAlgorithm {
 	public:
 		bool operator()(const char *s, Package *p ATTRIBUTE_UNUSED) ATTRIBUTE_NONNULL((2)) ATTRIBUTE_PURE;
+
+		void get_trigrams(TrigramSet *trigrams) const {
+			add_trigrams(trigrams, search_string);
+		}
 };
 
 /** Store distance to searchstring in Package and sort out packages with a
@@ -95,6 +139,8 @@ class FuzzyAlgorithm : public BaseAlgorithm {
 	protected:
 		Levenshtein max_levenshteindistance;
 
+		LevenshteinPattern pattern;
+
 		/** FIXME: We need to have a package->levenshtein mapping that we can
 		 * access from the static FuzzyAlgorithm::compare.
 		 * I really don't know how to do this .. */
@@ -104,8 +150,18 @@ class FuzzyAlgorithm : public BaseAlgorithm {
 		explicit FuzzyAlgorithm(Levenshtein max) : max_levenshteindistance(max) {
 		}
 
+		void setString(const std::string& s) {
+			search_string = s;
+			pattern.init(s);
+		}
+
 		bool operator()(const char *s, Package *p);
 
+		/// levenshtein_map is shared
+		bool can_match_parallel() const {
+			return false;
+		}
+
 		static bool compare(Package *p1, Package *p2) ATTRIBUTE_NONNULL_;
 
 		static bool sort_by_levenshtein() {
@@ -119,6 +175,10 @@ class FuzzyAlgorithm : public BaseAlgorithm {
 class PatternAlgorithm : public BaseAlgorithm {
 	public:
 		bool operator()(const char *s, Package *p ATTRIBUTE_UNUSED) ATTRIBUTE_NONNULL((2));
+
+		void get_trigrams(TrigramSet *trigrams) const {
+			add_pattern_trigrams(trigrams, search_string);
+		}
 };
 
 #endif  // SRC_SEARCH_ALGORITHMS_H_
@@ -13,64 +13,108 @@
 #include <cstring>
 
 #include <algorithm>
+#include <string>
 #include <vector>
 
+#include "eixTk/inttypes.h"
 #include "eixTk/likely.h"
 #include "eixTk/stringutils.h"
 #include "search/levenshtein.h"
 
+using std::string;
 using std::vector;
 
 using std::min;
 
-/**
- * Calculates the Levenshtein distance of two strings
- * @param str_a string a
- * @param str_b string b
- * @return int Levenshtein distance of str_a <> str_b
- */
-Levenshtein get_levenshtein_distance(const char *str_a, const char *str_b) {
-	size_t n(strlen(str_a));
-	size_t m(strlen(str_b));
-	if(n == 0) {
-		return m;
+const string::size_type LevenshteinPattern::word_bits;
+
+void LevenshteinPattern::init(const string& pattern) {
+	m_pattern.resize(pattern.size());
+	for(string::size_type i(0); likely(i != pattern.size()); ++i) {
+		m_pattern[i] = tolower(pattern[i], localeC);
 	}
-	if(m == 0) {
-		return n;
+	memset(m_peq, 0, sizeof(m_peq));
+	if(m_pattern.size() > word_bits) {
+		return;
 	}
-
-	typedef vector<Levenshtein> LevVec;
-	typedef vector<LevVec> LevArr;
-
-	// initialize the matrix' dimensions
-	LevArr matrix(n + 1);
-	matrix[0].resize(m + 1);
-	for(LevArr::size_type i(1); likely(i <= n); ++i) {
-		matrix[i].resize(m + 1);
-		fill(matrix[i].begin(), matrix[i].end(), 0);
+	for(string::size_type i(0); likely(i != m_pattern.size()); ++i) {
+		m_peq[static_cast<unsigned char>(m_pattern[i])] |= (static_cast<Word>(1) << i);
 	}
+}
 
-	// fill the 1st column/row with str_a / str_b
-	for(LevArr::size_type i(0); likely(i <= n); ++i) {
-		matrix[i][0] = i;
+Levenshtein LevenshteinPattern::distance(const char *str, Levenshtein max) const {
+	string::size_type m(m_pattern.size());
+	string::size_type n(strlen(str));
+	string::size_type diff((m > n) ? (m - n) : (n - m));
+	if(diff > max) {
+		return static_cast<Levenshtein>(diff);
 	}
-	for(LevVec::size_type j(0); likely(j <= m); ++j) {
-		matrix[0][j] = j;
+	if(m == 0) {
+		return static_cast<Levenshtein>(n);
+	}
+	if(unlikely(m > word_bits)) {
+		return distance_matrix(str, max);
 	}
 
-	// calculate the matrix
-	for(LevArr::size_type i(1); likely(i <= n); ++i) {
-		for(LevVec::size_type j(1); likely(j <= m); ++j) {
-			char ci(tolower(str_a[i - 1], localeC));
-			char cj(tolower(str_b[j - 1], localeC));
-
-			Levenshtein a(matrix[i - 1][j] + 1);
-			Levenshtein b(matrix[i][j - 1] + 1);
-			Levenshtein c(matrix[i - 1][j - 1] + (ci != cj));
+	// The vertical deltas of the current column of the matrix are stored
+	// bitwise in pv (+1) and mv (-1); score is the last entry of the column.
+	Word last(static_cast<Word>(1) << (m - 1));
+	Word pv(~static_cast<Word>(0));
+	Word mv(0);
+	Levenshtein score(m);
+	for(string::size_type j(0); likely(j != n); ++j) {
+		Word eq(m_peq[static_cast<unsigned char>(tolower(str[j], localeC))]);
+		Word xv(eq | mv);
+		Word xh((((eq & pv) + pv) ^ pv) | eq);
+		Word ph(mv | ~(xh | pv));
+		Word mh(pv & xh);
+		if(ph & last) {
+			++score;
+		} else if(mh & last) {
+			--score;
+		}
+		// The first row of the matrix increases by 1 in every column
+		ph = (ph << 1) | 1;
+		mh <<= 1;
+		pv = mh | ~(xv | ph);
+		mv = ph & xv;
+		// Each remaining character can decrease the score by at most 1
+		if(unlikely(score > max) && (score - max > n - j - 1)) {
+			return score;
+		}
+	}
+	return score;
+}
 
-			matrix[i][j] = min(a, min(b, c));
+Levenshtein LevenshteinPattern::distance_matrix(const char *str, Levenshtein max) const {
+	string::size_type n(strlen(str));
+	// Only two rows of the matrix are needed at a time
+	vector<Levenshtein> prev(n + 1), curr(n + 1);
+	for(string::size_type j(0); likely(j <= n); ++j) {
+		prev[j] = j;
+	}
+	for(string::size_type i(1); likely(i <= m_pattern.size()); ++i) {
+		char ci(m_pattern[i - 1]);
+		Levenshtein row_min(curr[0] = i);
+		for(string::size_type j(1); likely(j <= n); ++j) {
+			Levenshtein c(prev[j - 1] + (ci != tolower(str[j - 1], localeC)));
+			curr[j] = min(min(prev[j] + 1, curr[j - 1] + 1), c);
+			row_min = min(row_min, curr[j]);
+		}
+		if(row_min > max) {
+			return row_min;
 		}
+		prev.swap(curr);
 	}
+	return prev[n];
+}
 
-	return matrix[n][m];
+/**
+ * Calculates the Levenshtein distance of two strings
+ * @param str_a string a
+ * @param str_b string b
+ * @return int Levenshtein distance of str_a <> str_b
+ */
+Levenshtein get_levenshtein_distance(const char *str_a, const char *str_b) {
+	return LevenshteinPattern(str_a).distance(str_b, ~static_cast<Levenshtein>(0));
 }
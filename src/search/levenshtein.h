@@ -9,8 +9,45 @@
 #ifndef SRC_SEARCH_LEVENSHTEIN_H_
 #define SRC_SEARCH_LEVENSHTEIN_H_ 1
 
+#include <string>
+
+#include "eixTk/inttypes.h"
+
 typedef unsigned int Levenshtein;
 
+/** A pattern prepared for calculating its Levenshtein distance (ignoring
+ * case) to many strings. For patterns of at most 64 characters, the
+ * bit-parallel algorithm of Myers (in the formulation of Hyyrö) is used
+ * which needs neither a matrix nor heap allocation. */
+class LevenshteinPattern {
+	public:
+		LevenshteinPattern() {
+			init("");
+		}
+
+		explicit LevenshteinPattern(const std::string& pattern) {
+			init(pattern);
+		}
+
+		void init(const std::string& pattern);
+
+		/** @return the Levenshtein distance of the pattern <> str or
+		 * some value larger than max if the distance is larger than max */
+		Levenshtein distance(const char *str, Levenshtein max) const ATTRIBUTE_NONNULL_;
+
+	private:
+		typedef uint64_t Word;
+		static const std::string::size_type word_bits = 64;
+
+		/** The lowercase pattern */
+		std::string m_pattern;
+
+		/** Bit i of m_peq[c] is set if the pattern has c at position i */
+		Word m_peq[256];
+
+		Levenshtein distance_matrix(const char *str, Levenshtein max) const ATTRIBUTE_NONNULL_;
+};
+
 /** Calculates the Levenshtein distance of two strings.
  * Reference: http://www.merriampark.com/ld.htm
  * @param str_a string a
@@ -13,9 +13,12 @@
 #include <cstdlib>
 #endif
 
+#include <algorithm>
 #include <iostream>
+#include <iterator>
 #include <stack>
 
+#include "database/header.h"
 #include "eixTk/i18n.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
@@ -24,6 +27,10 @@
 #include "search/packagetest.h"
 
 using std::cerr;
+using std::back_inserter;
+using std::set_intersection;
+using std::sort;
+using std::unique;
 #ifdef DEBUG_MATCHTREE
 using std::cout;
 #endif
@@ -74,6 +81,51 @@ bool MatchAtomOperator::match(PackageReader *p) {
 	return is_match;
 }
 
+bool MatchAtomOperator::get_selection(IndexSelection *sel) const {
+	if(m_negate || (m_left == NULLPTR) || (m_right == NULLPTR)) {
+		return false;
+	}
+	IndexSelection left, right;
+	bool have_left(m_left->get_selection(&left));
+	bool have_right(m_right->get_selection(&right));
+	if(m_operator == AtomOr) {
+		// Both sides must be restricted
+		if(!(have_left && have_right)) {
+			return false;
+		}
+		sel->insert(sel->end(), left.begin(), left.end());
+		sel->insert(sel->end(), right.begin(), right.end());
+		return true;
+	}
+	// It suffices that one side is restricted
+	if(have_left && have_right) {
+		sort(left.begin(), left.end());
+		sort(right.begin(), right.end());
+		set_intersection(left.begin(), left.end(),
+			right.begin(), right.end(), back_inserter(*sel));
+	} else if(have_left) {
+		sel->insert(sel->end(), left.begin(), left.end());
+	} else if(have_right) {
+		sel->insert(sel->end(), right.begin(), right.end());
+	} else {
+		return false;
+	}
+	return true;
+}
+
+void MatchAtomOperator::get_trigrams(TrigramSet *trigrams) const {
+	if(m_negate || (m_left == NULLPTR) || (m_right == NULLPTR)) {
+		return;
+	}
+	m_left->get_trigrams(trigrams);
+	m_right->get_trigrams(trigrams);
+}
+
+bool MatchAtomOperator::can_match_parallel() const {
+	return (((m_left == NULLPTR) || m_left->can_match_parallel()) &&
+		((m_right == NULLPTR) || m_right->can_match_parallel()));
+}
+
 MatchAtomTest::~MatchAtomTest() {
 #ifndef DEBUG_MATCHTREE
 	delete m_test;
@@ -106,6 +158,41 @@ bool MatchAtomTest::match(PackageReader *p) {
 #endif
 }
 
+bool MatchAtomTest::get_selection(IndexSelection *sel) const {
+#ifdef DEBUG_MATCHTREE
+	UNUSED(sel);
+	return false;
+#else
+	if(m_negate || (m_pipe != NULLPTR) || (m_test == NULLPTR)) {
+		return false;
+	}
+	return m_test->get_selection(sel);
+#endif
+}
+
+void MatchAtomTest::get_trigrams(TrigramSet *trigrams) const {
+#ifdef DEBUG_MATCHTREE
+	UNUSED(trigrams);
+#else
+	if(m_negate || (m_pipe != NULLPTR) || (m_test == NULLPTR)) {
+		return;
+	}
+	m_test->get_trigrams(trigrams);
+#endif
+}
+
+bool MatchAtomTest::can_match_parallel() const {
+#ifdef DEBUG_MATCHTREE
+	return false;
+#else
+	if((m_pipe != NULLPTR) && ((*m_pipe) != NULLPTR) &&
+		!(*m_pipe)->can_match_parallel()) {
+		return false;
+	}
+	return ((m_test == NULLPTR) || m_test->can_match_parallel());
+#endif
+}
+
 void MatchAtomTest::set_test(PackageTest *gtest) {
 #ifdef DEBUG_MATCHTREE
 	static int t_count(0);
@@ -138,6 +225,27 @@ bool MatchTree::match(PackageReader *p) {
 	return ((root == NULLPTR) || root->match(p));
 }
 
+bool MatchTree::get_selection(IndexSelection *sel) const {
+	sel->clear();
+	if((root == NULLPTR) || !root->get_selection(sel)) {
+		sel->clear();
+		return false;
+	}
+	sort(sel->begin(), sel->end());
+	sel->erase(unique(sel->begin(), sel->end()), sel->end());
+	return true;
+}
+
+void MatchTree::get_trigrams(TrigramSet *trigrams) const {
+	if(root != NULLPTR) {
+		root->get_trigrams(trigrams);
+	}
+}
+
+bool MatchTree::can_match_parallel() const {
+	return ((root == NULLPTR) || root->can_match_parallel());
+}
+
 void MatchTree::set_pipetest(PackageTest *gtest) {
 	MatchAtomTest *p(new MatchAtomTest);
 	p->set_test(gtest);
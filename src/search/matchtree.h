@@ -10,7 +10,10 @@
 
 #include <stack>
 
+#include "database/header.h"
+#include "database/trigrams.h"
 #include "eixTk/null.h"
+#include "eixTk/unused.h"
 
 class MatchAtomOperator;
 class MatchAtomTest;
@@ -39,6 +42,23 @@ class MatchAtom {
 		 * @return true if match; else false */
 		virtual bool match(PackageReader *p) ATTRIBUTE_PURE;
 
+		/** Add all packages which can possibly match to sel.
+		 * @return false if this cannot be decided by the names */
+		virtual bool get_selection(IndexSelection *sel ATTRIBUTE_UNUSED) const ATTRIBUTE_NONNULL_ ATTRIBUTE_CONST_VIRTUAL {
+			UNUSED(sel);
+			return false;
+		}
+
+		/** @return true if match() can be called in parallel threads */
+		virtual bool can_match_parallel() const ATTRIBUTE_CONST_VIRTUAL {
+			return true;
+		}
+
+		/** Add the trigrams which get_selection() might use */
+		virtual void get_trigrams(TrigramSet *trigrams ATTRIBUTE_UNUSED) const {
+			UNUSED(trigrams);
+		}
+
 		virtual MatchAtomOperator *as_operator() {
 			return NULLPTR;
 		}
@@ -64,6 +84,12 @@ class MatchAtomOperator : public MatchAtom {
 
 		bool match(PackageReader *p);
 
+		bool get_selection(IndexSelection *sel) const ATTRIBUTE_NONNULL_;
+
+		bool can_match_parallel() const ATTRIBUTE_PURE;
+
+		void get_trigrams(TrigramSet *trigrams) const ATTRIBUTE_NONNULL_;
+
 		MatchAtomOperator *as_operator() {
 			return this;
 		}
@@ -83,6 +109,12 @@ class MatchAtomTest : public MatchAtom {
 
 		bool match(PackageReader *p);
 
+		bool get_selection(IndexSelection *sel) const ATTRIBUTE_NONNULL_;
+
+		bool can_match_parallel() const ATTRIBUTE_PURE;
+
+		void get_trigrams(TrigramSet *trigrams) const ATTRIBUTE_NONNULL_;
+
 		void set_test(PackageTest *gtest);
 
 		MatchAtomTest *as_test() {
@@ -137,6 +169,19 @@ class MatchTree {
 
 		bool match(PackageReader *p);
 
+		/** Store in sel (in database order) all packages which can
+		 * possibly match. The category index must have been read.
+		 * @return false if all packages must be tested */
+		bool get_selection(IndexSelection *sel) const ATTRIBUTE_NONNULL_;
+
+		/** @return true if match() can be called in parallel threads
+		 * for different packages */
+		bool can_match_parallel() const ATTRIBUTE_PURE;
+
+		/** Add the trigrams which get_selection() might use; these must be
+		 * read by Database::read_trigrams() before get_selection() */
+		void get_trigrams(TrigramSet *trigrams) const ATTRIBUTE_NONNULL_;
+
 		void set_pipetest(PackageTest *gtest);
 
 		void parse_test(PackageTest *gtest, bool with_pipe);
@@ -14,6 +14,7 @@
 #include <string>
 #include <vector>
 
+#include "database/header.h"
 #include "database/package_reader.h"
 #include "eixTk/assert.h"
 #include "eixTk/eixint.h"
@@ -152,6 +153,9 @@ void PackageTest::calculateNeeds() {
 		setNeeds(PackageReader::NAME);
 	if(installed)
 		setNeeds(PackageReader::NAME);
+	// The fuzzy algorithm stores its result by the name
+	if(algorithm != NULLPTR)
+		setNeeds(PackageReader::NAME);
 	if(!Depend::use_depend) {
 		field &= ~DEPS;
 	}
@@ -417,6 +421,60 @@ void PackageTest::finalize() {
 	calculateNeeds();
 }
 
+void PackageTest::get_trigrams(TrigramSet *trigrams) const {
+	// The trigram index contains only these fields
+	if((algorithm == NULLPTR) ||
+		(field == NONE) || ((field & ~(NAME|DESCRIPTION|HOMEPAGE)) != NONE)) {
+		return;
+	}
+	algorithm->get_trigrams(trigrams);
+}
+
+bool PackageTest::get_selection(IndexSelection *sel) const {
+	if((algorithm == NULLPTR) || !algorithm->is_exact() ||
+		(field == NONE) || ((field & ~(NAME|CATEGORY|CATEGORY_NAME)) != NONE)) {
+		TrigramSet trigrams;
+		get_trigrams(&trigrams);
+		return header->select_trigrams(sel, trigrams);
+	}
+	const string& s(algorithm->getString());
+	if((field & NAME) != NONE) {
+		header->select_package(sel, NULLPTR, s);
+	}
+	if((field & CATEGORY) != NONE) {
+		header->select_category(sel, s);
+	}
+	if((field & CATEGORY_NAME) != NONE) {
+		string::size_type slash(s.find('/'));
+		if(slash != string::npos) {
+			header->select_package(sel, s.substr(0, slash).c_str(), s.substr(slash + 1));
+		}
+	}
+	return true;
+}
+
+bool PackageTest::can_match_parallel() const {
+	if(algorithm != NULLPTR) {
+		if(!algorithm->can_match_parallel()) {
+			return false;
+		}
+		// These fields only use data of the package itself
+		if((field & ~(NAME|DESCRIPTION|LICENSE|CATEGORY|CATEGORY_NAME|HOMEPAGE|IUSE|SLOT|FULLSLOT)) != NONE) {
+			return false;
+		}
+	}
+	return (!(installed || obsolete || upgrade || binary || world || worldset) &&
+		(in_overlay_inst_list == NULLPTR) &&
+		(from_overlay_inst_list == NULLPTR) &&
+		(from_foreign_overlay_inst_list == NULLPTR) &&
+		(restrictions == ExtendedVersion::RESTRICT_NONE) &&
+		(properties == ExtendedVersion::PROPERTIES_NONE) &&
+		(test_stability_default == STABLE_NONE) &&
+		(test_stability_local == STABLE_NONE) &&
+		(test_stability_nonlocal == STABLE_NONE) &&
+		(test_instability == STABLE_NONE));
+}
+
 /** Return true if pkg matches test. */
 bool PackageTest::stringMatch(Package *pkg) const {
 	if((((field & NAME) != NONE) && (*algorithm)(pkg->name.c_str(), pkg))
@@ -14,7 +14,9 @@
 #include <string>
 #include <vector>
 
+#include "database/header.h"
 #include "database/package_reader.h"
+#include "database/trigrams.h"
 #include "eixTk/constexpr.h"
 #include "eixTk/inttypes.h"
 #include "eixTk/likely.h"
@@ -106,6 +108,20 @@ class PackageTest {
 
 		bool match(PackageReader *pkg) const;
 
+		/** If the test can only match packages with certain names,
+		    add these packages to sel (using the category index).
+		    @return false if the test is not restricted in this way */
+		bool get_selection(IndexSelection *sel) const ATTRIBUTE_NONNULL_;
+
+		/** Add the trigrams which every package matching the test
+		    must contain (in its name, description, or homepage) */
+		void get_trigrams(TrigramSet *trigrams) const ATTRIBUTE_NONNULL_;
+
+		/** @return true if match() can be called in parallel threads for
+		    different packages, i.e. if the test does not need the lazily
+		    filled data of VarDbPkg, SetStability, or PortageSettings */
+		bool can_match_parallel() const ATTRIBUTE_PURE;
+
 		/** Set defaults (e.g. matchfield if unspecified),
 		    calculate needs. */
 		void finalize();
@@ -337,9 +353,7 @@ class PackageTest {
 		bool stringMatch(Package *pkg) const ATTRIBUTE_NONNULL_;
 
 		void setNeeds(const PackageReader::Attributes i) {
-			if(need < i) {
-				need = i;
-			}
+			need |= i;
 		}
 
 		/** Get the Fetched-value that is required to determine the match */